@@ -0,0 +1,78 @@
+/**
+ * Binary input event format of the City Water Supply model
+ *
+ * Compiled from the text input files (one "time value" command per line) by
+ * tools/compile_input.cpp: a header then fixed width records sorted by time,
+ * so BinaryInputReader can map the file and read the records in place.
+ * read_text() parses a text input file into the same records in memory.
+**/
+
+#ifndef _BINARY_INPUT_FORMAT_HPP__
+#define _BINARY_INPUT_FORMAT_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace binary_input {
+
+    const char     magic[8] = {'C', 'W', 'S', 'I', 'N', 'P', 'U', 'T'};
+    const uint32_t version  = 1;
+
+    struct header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t record_count;
+    };
+
+    struct record {
+        int64_t time;  // Milliseconds, records are sorted by time
+        int32_t value;
+        int32_t reserved;
+    };
+    static_assert(sizeof(record) == 16, "Records must stay fixed width");
+
+    // Parses "hh:mm:ss[:mmm] value", returns false if the line is not a command
+    inline bool parse_command(const char * line, record& r) {
+        long long h, m, s, ms = 0;
+        int value, consumed = 0;
+        if (sscanf(line, "%lld:%lld:%lld%n", &h, &m, &s, &consumed) != 3) return false;
+        line += consumed;
+        if (*line == ':') {
+            if (sscanf(line, ":%lld%n", &ms, &consumed) != 1) return false;
+            line += consumed;
+        }
+        if (sscanf(line, "%d", &value) != 1) return false;
+        r.time = ((h * 60 + m) * 60 + s) * 1000 + ms;
+        r.value = value;
+        r.reserved = 0;
+        return true;
+    }
+
+    // Records of a text input file sorted by time, commands at the same time keep the order of the file
+    inline std::vector<record> read_text(const std::string& path) {
+        FILE * in = fopen(path.c_str(), "r");
+        if (!in) throw std::runtime_error("Cannot read " + path);
+        std::vector<record> records;
+        char line[4096];
+        for (long number = 1; fgets(line, sizeof(line), in); number++) {
+            const char * start = line + strspn(line, " \t");
+            if (*start == '\0' || *start == '\n' || *start == '\r' || *start == '#') continue;
+            record r;
+            if (!parse_command(start, r)) {
+                fclose(in);
+                throw std::runtime_error(path + ":" + std::to_string(number) + ": cannot parse '" + strtok(line, "\r\n") + "'");
+            }
+            records.push_back(r);
+        }
+        fclose(in);
+        std::stable_sort(records.begin(), records.end(), [](const record& a, const record& b) { return a.time < b.time; });
+        return records;
+    }
+}
+#endif // _BINARY_INPUT_FORMAT_HPP__
@@ -0,0 +1,147 @@
+/**
+ * Input reader of compiled (binary) input files, see tools/compile_input.cpp
+ *
+ * Same output port as the iestream_input<int> readers, so it can replace them
+ * in the coupled models. The file is memory mapped and the records are read in
+ * place: no parsing at startup or per event. Commands at the same time are
+ * sent together in one bag. A reader can also be built on records already
+ * in memory (load_input() of a text file), shared by all the models built
+ * from them.
+**/
+
+#ifndef _BINARY_INPUT_READER_HPP__
+#define _BINARY_INPUT_READER_HPP__
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/basic_model/pdevs/iestream.hpp>
+
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binary_input_format.hpp"
+
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+using namespace std;
+
+// Read only mapping of a compiled input file, or records parsed from a text file, shared by the copies of a reader
+class binary_input_file {
+    void * mapping = MAP_FAILED;
+    size_t size = 0;
+    vector<binary_input::record> parsed;
+public:
+    const binary_input::record * records = nullptr;
+    uint64_t count = 0;
+    string path; // File the records come from, empty if they were built in memory
+
+    binary_input_file(const string& path) : path(path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(binary_input::header)) {
+            if (fd >= 0) close(fd);
+            throw runtime_error("Cannot read input " + path);
+        }
+        size = st.st_size;
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) throw runtime_error("Cannot map input " + path);
+        binary_input::header h;
+        memcpy(&h, mapping, sizeof(h));
+        if (memcmp(h.magic, binary_input::magic, sizeof(h.magic)) != 0 || h.version != binary_input::version
+                || h.record_size != sizeof(binary_input::record) || sizeof(h) + h.record_count * h.record_size != size) {
+            munmap(mapping, size);
+            throw runtime_error(path + " is not a compiled input file (version " + to_string(binary_input::version) + ")");
+        }
+        records = reinterpret_cast<const binary_input::record *>(static_cast<const char *>(mapping) + sizeof(h));
+        count = h.record_count;
+    }
+    binary_input_file(vector<binary_input::record> records, string path = "") : parsed(move(records)), path(move(path)) {
+        this->records = parsed.data();
+        count = parsed.size();
+    }
+    ~binary_input_file() {
+        if (mapping != MAP_FAILED) munmap(mapping, size);
+    }
+    binary_input_file(const binary_input_file&) = delete;
+    binary_input_file& operator=(const binary_input_file&) = delete;
+};
+
+// Maps a compiled input file (.bin), or parses a text one
+inline shared_ptr<const binary_input_file> load_input(const string& path) {
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0) return make_shared<const binary_input_file>(path);
+    return make_shared<const binary_input_file>(binary_input::read_text(path), path);
+}
+
+template<typename TIME> class BinaryInputReader {
+    public:
+    // Ports
+    using input_ports  = tuple<>;
+    using output_ports = tuple<typename iestream_input_defs<int>::out>;
+    // State
+    struct state_type {
+        uint64_t next; // Index of the next record to send
+        int64_t  last; // Time of the last records sent, in milliseconds
+    };
+    state_type state;
+    string file_path;
+    shared_ptr<const binary_input_file> file;
+    // Constructors
+    BinaryInputReader() {
+        state.next = 0;
+        state.last = 0;
+    }
+    BinaryInputReader(const char * file_path) : BinaryInputReader() {
+        this->file_path = file_path;
+        file = make_shared<const binary_input_file>(file_path);
+    }
+    BinaryInputReader(shared_ptr<const binary_input_file> file) : BinaryInputReader() {
+        file_path = file->path;
+        this->file = move(file);
+    }
+    // internal transition
+    void internal_transition() {
+        state.last = file->records[state.next].time;
+        while (state.next < file->count && file->records[state.next].time == state.last) state.next++;
+    }
+    // external transition
+    void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+    }
+    // confluence transition
+    void confluence_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+        internal_transition();
+    }
+    // output function
+    typename make_message_bags<output_ports>::type output() const {
+        typename make_message_bags<output_ports>::type bags;
+        vector<int>& out = get_messages<typename iestream_input_defs<int>::out>(bags);
+        int64_t time = file->records[state.next].time;
+        for (uint64_t i = state.next; i < file->count && file->records[i].time == time; i++) out.push_back(file->records[i].value);
+        return bags;
+    }
+    // time_advance function
+    TIME time_advance() const {
+        if (!file || state.next >= file->count) return numeric_limits<TIME>::infinity();
+        int64_t ms = file->records[state.next].time - state.last;
+        return TIME({int(ms / 3600000), int(ms / 60000 % 60), int(ms / 1000 % 60), int(ms % 1000)});
+    }
+
+    friend ostringstream& operator<<(ostringstream& os, const typename BinaryInputReader<TIME>::state_type& i) {
+        os << "next command: " << i.next;
+        return os;
+    }
+
+    friend bool operator==(const typename BinaryInputReader<TIME>::state_type& a, const typename BinaryInputReader<TIME>::state_type& b) {
+        return a.next == b.next && a.last == b.last;
+    }
+};
+#endif // _BINARY_INPUT_READER_HPP__
@@ -0,0 +1,288 @@
+/**
+ * Checkpoint support of the atomic models
+ *
+ * Opt-in: CHECKPOINTED_IF(CHECKPOINT, ATOMIC) names the atomic template to
+ * instantiate. When CHECKPOINT is true it wraps ATOMIC so the model can be
+ * saved to and restored from a checkpoint: its state, its random engine and
+ * the time of its last transition; otherwise it is ATOMIC itself, so runs
+ * that neither save nor restore a checkpoint are not touched. A restored
+ * model is started by the runner at the checkpoint time, so the wrapper
+ * shortens the first time advance and lengthens the first elapsed time by
+ * the time it had already spent in its state.
+ * The file format and the functions saving/restoring a whole TOP model are
+ * in top_model/checkpoint.hpp.
+**/
+
+#ifndef _CHECKPOINTED_HPP__
+#define _CHECKPOINTED_HPP__
+
+#define CHECKPOINTED_IF(CHECKPOINT, ATOMIC) checkpointed_if<CHECKPOINT, ATOMIC>::template type
+
+#include <cadmium/modeling/message_bag.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "reservoir.hpp"
+#include "water_supply_pump.hpp"
+#include "city_pump.hpp"
+#include "continuous_reservoir.hpp"
+#include "continuous_water_supply_pump.hpp"
+#include "continuous_city_pump.hpp"
+#include "binary_input_reader.hpp"
+
+using namespace std;
+using namespace cadmium;
+
+namespace checkpoint {
+
+    const char     magic[8] = {'C', 'W', 'S', 'C', 'H', 'K', 'P', 'T'};
+    const uint32_t version  = 4;
+
+    // Every value is little endian whatever the machine, floats as their IEEE 754 bits and bools as one byte,
+    // so a checkpoint loads on any machine with a build using the same volume type.
+    // Header: magic, uint32 version, uint32 model count, int64 time (milliseconds, simulation time of the checkpoint)
+    // Then per model: uint16 id length, id, uint8 kind, uint32 payload size, payload
+
+    enum kind : uint8_t {
+        reservoir                    = 1,
+        water_supply_pump            = 2,
+        city_pump                    = 3,
+        continuous_reservoir         = 4,
+        continuous_water_supply_pump = 5,
+        continuous_city_pump         = 6,
+        input_reader                 = 7,
+        binary_input_reader          = 8
+    };
+
+    // Volume type the reservoirs were saved with, a checkpoint only loads in a build with the same one
+    inline uint8_t volume_code(float)        { return 1; }
+    inline uint8_t volume_code(double)       { return 2; }
+    inline uint8_t volume_code(fixed_volume) { return 3; }
+
+    // Unsigned integer with the size of T, to write T byte by byte
+    template<size_t SIZE> struct bits;
+    template<> struct bits<1> { using type = uint8_t; };
+    template<> struct bits<2> { using type = uint16_t; };
+    template<> struct bits<4> { using type = uint32_t; };
+    template<> struct bits<8> { using type = uint64_t; };
+
+    // Payload of one model, fixed width values
+    struct writer {
+        ostream& os;
+        int64_t  time; // Checkpoint time
+        template<typename T> void put(const T& value) {
+            static_assert(is_trivially_copyable<T>::value, "Checkpoint values are written as their bits");
+            if constexpr (is_same<T, bool>::value) {
+                put<uint8_t>(value ? 1 : 0);
+            } else {
+                typename bits<sizeof(T)>::type v;
+                memcpy(&v, &value, sizeof(T));
+                char bytes[sizeof(T)];
+                for (size_t i = 0; i < sizeof(T); i++) bytes[i] = char(v >> (8 * i));
+                os.write(bytes, sizeof(T));
+            }
+        }
+        template<typename TIME> void put_time(const TIME& t) { put<int64_t>(time_to_ms(t)); }
+        void put_string(const string& s) {
+            put<uint32_t>(s.size());
+            os.write(s.data(), s.size());
+        }
+        void put_rng(const mt19937& rng) {
+            ostringstream oss;
+            oss << rng;
+            put_string(oss.str());
+        }
+    };
+
+    struct reader {
+        istream& is;
+        int64_t  time;     // Checkpoint time
+        bool     reseed;   // Give the random engines new seeds, to branch scenarios from the checkpoint
+        uint32_t seed;
+        uint32_t engines;  // Random engines restored so far, engine n is seeded from (seed, n)
+        template<typename T> T get() {
+            static_assert(is_trivially_copyable<T>::value, "Checkpoint values are read as their bits");
+            if constexpr (is_same<T, bool>::value) {
+                return get<uint8_t>() != 0;
+            } else {
+                unsigned char bytes[sizeof(T)];
+                if (!is.read(reinterpret_cast<char *>(bytes), sizeof(T))) throw runtime_error("Truncated checkpoint");
+                typename bits<sizeof(T)>::type v = 0;
+                for (size_t i = 0; i < sizeof(T); i++) v |= typename bits<sizeof(T)>::type(bytes[i]) << (8 * i);
+                T value;
+                memcpy(static_cast<void *>(&value), &v, sizeof(T));
+                return value;
+            }
+        }
+        template<typename TIME> TIME get_time() { return ms_to_time<TIME>(get<int64_t>()); }
+        string get_string() {
+            string s(get<uint32_t>(), '\0');
+            if (!is.read(&s[0], s.size())) throw runtime_error("Truncated checkpoint");
+            return s;
+        }
+        void get_rng(mt19937& rng) {
+            istringstream iss(get_string());
+            iss >> rng;
+            engines++;
+            if (reseed) {
+                seed_seq seq{seed, engines};
+                rng.seed(seq);
+            }
+        }
+    };
+}
+
+/****** State of each atomic model *******************/
+template<typename TIME, typename VOLUME> checkpoint::kind checkpoint_kind(const Reservoir<TIME, VOLUME>&) { return checkpoint::reservoir; }
+template<typename TIME, typename VOLUME> void save_state(checkpoint::writer& w, const Reservoir<TIME, VOLUME>& m) {
+    w.put(checkpoint::volume_code(m.state.volume)); w.put(m.state.volume); w.put(m.state.volume_error); w.put(m.state.reading); w.put(m.state.surface); w.put(m.state.height);
+}
+template<typename TIME, typename VOLUME> void load_state(checkpoint::reader& r, Reservoir<TIME, VOLUME>& m) {
+    if (r.get<uint8_t>() != checkpoint::volume_code(m.state.volume)) throw runtime_error("Checkpoint saved with another volume type (see atomics/volume.hpp)");
+    m.state.volume = r.get<VOLUME>(); m.state.volume_error = r.get<double>(); m.state.reading = r.get<bool>(); m.state.surface = r.get<float>(); m.state.height = r.get<float>();
+}
+
+template<typename TIME, typename VOLUME> checkpoint::kind checkpoint_kind(const WaterSupplyPump<TIME, VOLUME>&) { return checkpoint::water_supply_pump; }
+template<typename TIME, typename VOLUME> void save_state(checkpoint::writer& w, const WaterSupplyPump<TIME, VOLUME>& m) {
+    w.put(m.state.active); w.put(m.state.flow); w.put(m.state.period); w.put(m.state.blockage); w.put(m.state.max_level);
+    w.put(m.state.wait); w.put(m.state.blockage_probability); w.put_time(m.state.unblock_time);
+    w.put_rng(m.rng);
+}
+template<typename TIME, typename VOLUME> void load_state(checkpoint::reader& r, WaterSupplyPump<TIME, VOLUME>& m) {
+    m.state.active = r.get<bool>(); m.state.flow = r.get<float>(); m.state.period = r.get<float>(); m.state.blockage = r.get<bool>();
+    m.state.max_level = r.get<float>(); m.state.wait = r.get<bool>(); m.state.blockage_probability = r.get<double>();
+    m.state.unblock_time = r.get_time<TIME>();
+    r.get_rng(m.rng);
+}
+
+template<typename TIME, typename VOLUME> checkpoint::kind checkpoint_kind(const CityPump<TIME, VOLUME>&) { return checkpoint::city_pump; }
+template<typename TIME, typename VOLUME> void save_state(checkpoint::writer& w, const CityPump<TIME, VOLUME>& m) {
+    w.put(m.state.active); w.put(m.state.flow); w.put(m.state.period); w.put(m.state.min_level); w.put(m.state.wait);
+}
+template<typename TIME, typename VOLUME> void load_state(checkpoint::reader& r, CityPump<TIME, VOLUME>& m) {
+    m.state.active = r.get<bool>(); m.state.flow = r.get<float>(); m.state.period = r.get<float>(); m.state.min_level = r.get<float>();
+    m.state.wait = r.get<bool>();
+}
+
+template<typename TIME> checkpoint::kind checkpoint_kind(const ContinuousReservoir<TIME>&) { return checkpoint::continuous_reservoir; }
+template<typename TIME> void save_state(checkpoint::writer& w, const ContinuousReservoir<TIME>& m) {
+    w.put(m.state.volume); w.put(m.state.inflow); w.put(m.state.outflow); w.put(m.state.surface); w.put(m.state.height); w.put(m.state.sigma);
+    w.put<uint32_t>(m.state.thresholds.size());
+    for (float t : m.state.thresholds) w.put(t);
+}
+template<typename TIME> void load_state(checkpoint::reader& r, ContinuousReservoir<TIME>& m) {
+    m.state.volume = r.get<double>(); m.state.inflow = r.get<double>(); m.state.outflow = r.get<double>();
+    m.state.surface = r.get<float>(); m.state.height = r.get<float>(); m.state.sigma = r.get<double>();
+    m.state.thresholds.resize(r.get<uint32_t>());
+    for (float& t : m.state.thresholds) t = r.get<float>();
+}
+
+template<typename TIME> checkpoint::kind checkpoint_kind(const ContinuousWaterSupplyPump<TIME>&) { return checkpoint::continuous_water_supply_pump; }
+template<typename TIME> void save_state(checkpoint::writer& w, const ContinuousWaterSupplyPump<TIME>& m) {
+    w.put(m.state.active); w.put(m.state.flow); w.put(m.state.period); w.put(m.state.blockage); w.put(m.state.max_level);
+    w.put(m.state.wait); w.put(m.state.blockage_probability); w.put_time(m.state.unblock_time); w.put_time(m.state.next_change);
+    w.put(m.state.rate);
+    w.put_rng(m.rng);
+}
+template<typename TIME> void load_state(checkpoint::reader& r, ContinuousWaterSupplyPump<TIME>& m) {
+    m.state.active = r.get<bool>(); m.state.flow = r.get<float>(); m.state.period = r.get<float>(); m.state.blockage = r.get<bool>();
+    m.state.max_level = r.get<float>(); m.state.wait = r.get<bool>(); m.state.blockage_probability = r.get<double>();
+    m.state.unblock_time = r.get_time<TIME>(); m.state.next_change = r.get_time<TIME>();
+    m.state.rate = r.get<float>();
+    r.get_rng(m.rng);
+}
+
+template<typename TIME> checkpoint::kind checkpoint_kind(const ContinuousCityPump<TIME>&) { return checkpoint::continuous_city_pump; }
+template<typename TIME> void save_state(checkpoint::writer& w, const ContinuousCityPump<TIME>& m) {
+    w.put(m.state.active); w.put(m.state.flow); w.put(m.state.min_level); w.put(m.state.wait); w.put(m.state.rate);
+}
+template<typename TIME> void load_state(checkpoint::reader& r, ContinuousCityPump<TIME>& m) {
+    m.state.active = r.get<bool>(); m.state.flow = r.get<float>(); m.state.min_level = r.get<float>(); m.state.wait = r.get<bool>();
+    m.state.rate = r.get<float>();
+}
+
+// The file is read again when the model is built (mapped, or parsed if it is a text file), only the position in it is restored
+template<typename TIME> checkpoint::kind checkpoint_kind(const BinaryInputReader<TIME>&) { return checkpoint::binary_input_reader; }
+template<typename TIME> void save_state(checkpoint::writer& w, const BinaryInputReader<TIME>& m) {
+    w.put_string(m.file_path); w.put(m.state.next); w.put(m.state.last);
+}
+template<typename TIME> void load_state(checkpoint::reader& r, BinaryInputReader<TIME>& m) {
+    r.get_string(); m.state.next = r.get<uint64_t>(); m.state.last = r.get<int64_t>();
+}
+
+/****** Models that can be checkpointed, found by dynamic_cast in the TOP model *******************/
+struct checkpointable {
+    virtual ~checkpointable() = default;
+    virtual checkpoint::kind kind() const = 0;
+    virtual void save(checkpoint::writer& w) const = 0;
+    virtual void load(checkpoint::reader& r) = 0;
+};
+
+template<template<typename> class ATOMIC> struct checkpointed {
+    template<typename TIME> class type : public ATOMIC<TIME>, public checkpointable {
+        using base = ATOMIC<TIME>;
+        TIME last = TIME();   // Time of the last transition as seen by the runner
+        TIME offset = TIME(); // Time spent in the state before the checkpoint, until the first transition after a restore
+        mutable TIME next = TIME();
+    public:
+        using base::base;
+        type() = default;
+
+        void internal_transition() {
+            base::internal_transition();
+            last = next;
+            offset = TIME();
+        }
+        void external_transition(TIME e, typename make_message_bags<typename base::input_ports>::type mbs) {
+            base::external_transition(e + offset, move(mbs));
+            last = last + e;
+            offset = TIME();
+        }
+        void confluence_transition(TIME e, typename make_message_bags<typename base::input_ports>::type mbs) {
+            base::confluence_transition(e + offset, move(mbs));
+            last = last + e;
+            offset = TIME();
+        }
+        TIME time_advance() const {
+            TIME next_internal = base::time_advance() - offset;
+            next = last + next_internal;
+            return next_internal;
+        }
+
+        checkpoint::kind kind() const override {
+            return checkpoint_kind(static_cast<const base&>(*this));
+        }
+        // Text input readers are restored at the checkpoint time on the rest of their file, so nothing was spent in their state
+        void save(checkpoint::writer& w) const override {
+            w.put<int64_t>(kind() == checkpoint::input_reader ? w.time : time_to_ms(last - offset));
+            save_state(w, static_cast<const base&>(*this));
+        }
+        void load(checkpoint::reader& r) override {
+            TIME previous = r.get_time<TIME>();
+            last = ms_to_time<TIME>(r.time);
+            offset = last - previous;
+            load_state(r, static_cast<base&>(*this));
+        }
+    };
+};
+
+// ATOMIC itself, or wrapped by checkpointed when CHECKPOINT is true
+template<bool CHECKPOINT, template<typename> class ATOMIC> struct checkpointed_if {
+    template<typename TIME> using type = ATOMIC<TIME>;
+};
+template<template<typename> class ATOMIC> struct checkpointed_if<true, ATOMIC> {
+    template<typename TIME> using type = typename checkpointed<ATOMIC>::template type<TIME>;
+};
+#endif // _CHECKPOINTED_HPP__
@@ -17,21 +17,33 @@
 #include <string>
 #include <random>
 
+#include "model_parameters.hpp"
+#include "volume.hpp"
+#include "tick_time.hpp"
+
 using namespace cadmium;
 using namespace std;
 
-// Port Definition
+// Port Definition, the flow packets are volumes of water (see volume.hpp)
 struct CityPump_defs {
     struct start : public in_port<int> {}; // Start can be used to simulate start, stop, and power commands
     struct level : public in_port<float> {};
-    struct flow  : public out_port<float> {};
+    struct flow  : public out_port<volume_type> {};
+};
+// Ports of a pump with another volume type than the build's, the port names show in the message logs
+template<typename VOLUME> struct CityPump_defs_of {
+    struct start : public in_port<int> {};
+    struct level : public in_port<float> {};
+    struct flow  : public out_port<VOLUME> {};
 };
+template<> struct CityPump_defs_of<volume_type> : public CityPump_defs {};
 
-template<typename TIME> class CityPump {
+template<typename TIME, typename VOLUME = volume_type> class CityPump {
+    using defs = CityPump_defs_of<VOLUME>;
     public:
     // Ports
-    using input_ports  = tuple<typename CityPump_defs::start, typename CityPump_defs::level>;
-    using output_ports = tuple<typename CityPump_defs::flow>;
+    using input_ports  = tuple<typename defs::start, typename defs::level>;
+    using output_ports = tuple<typename defs::flow>;
     // State
     struct state_type {
         bool  active;
@@ -41,12 +53,13 @@ template<typename TIME> class CityPump {
         bool wait;
     };
     state_type state;
-    // Constructor
-    CityPump() {
+    // Constructors
+    CityPump() : CityPump(model_parameters()) {}
+    CityPump(const model_parameters& parameters) {
         state.active = false;
-        state.flow = 0.4; //m^3 / s
+        state.flow = parameters.city_flow; //m^3 / s
         state.period = 30.0; // seconds
-        state.min_level = 0.5;
+        state.min_level = parameters.min_level;
         state.wait = false;
     }
     // internal transition
@@ -54,8 +67,8 @@ template<typename TIME> class CityPump {
     }
     // external transition
     void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
-        vector<int> start = get_messages<typename CityPump_defs::start>(mbs);
-        vector<float> level = get_messages<typename CityPump_defs::level>(mbs);
+        const vector<int>& start = get_messages<typename defs::start>(mbs);
+        const vector<float>& level = get_messages<typename defs::level>(mbs);
         if(start.size()>1 || level.size()>1) assert(false && "One message at a time");               
         
         if (start.size() > 0) {
@@ -81,25 +94,27 @@ template<typename TIME> class CityPump {
     // output function
     typename make_message_bags<output_ports>::type output() const {
         typename make_message_bags<output_ports>::type bags;
-        vector<float> flow;            
-        flow.push_back(state.flow * state.period);
-        get_messages<typename CityPump_defs::flow>(bags) = flow;
+        get_messages<typename defs::flow>(bags).push_back(VOLUME(state.flow * state.period));
         return bags;
     }
     // time_advance function
     TIME time_advance() const {
         TIME next_internal;
         if (state.active && !state.wait) {
-            next_internal = TIME("00:00:30:000"); // Time until next packet of water
+            next_internal = model_durations<TIME>::packet(); // Time until next packet of water
         } else {
             next_internal = numeric_limits<TIME>::infinity();
         }
         return next_internal;
     }
 
-    friend ostringstream& operator<<(ostringstream& os, const typename CityPump<TIME>::state_type& i) {
+    friend ostringstream& operator<<(ostringstream& os, const typename CityPump<TIME, VOLUME>::state_type& i) {
         os << "active: " << i.active; 
         return os;
     }
+
+    friend bool operator==(const typename CityPump<TIME, VOLUME>::state_type& a, const typename CityPump<TIME, VOLUME>::state_type& b) {
+        return a.active == b.active && a.flow == b.flow && a.period == b.period && a.min_level == b.min_level && a.wait == b.wait;
+    }
 };
 #endif // _CITY_PUMP__
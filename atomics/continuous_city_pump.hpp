@@ -0,0 +1,99 @@
+/**
+ * Continuous (rate based) variant of the CityPump atomic model
+ *
+ * Instead of a water packet every 30 seconds the pump outputs the change of
+ * its flow rate (m^3/s) when it starts, stops or starts/stops waiting for the
+ * reservoir level, and is passive the rest of the time. Same ports and level
+ * thresholds as CityPump.
+**/
+
+#ifndef _CONTINUOUS_CITY_PUMP_HPP__
+#define _CONTINUOUS_CITY_PUMP_HPP__
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+
+#include <limits>
+#include <assert.h>
+#include <string>
+
+#include "city_pump.hpp"
+
+using namespace cadmium;
+using namespace std;
+
+template<typename TIME> class ContinuousCityPump {
+    public:
+    // Ports
+    using input_ports  = tuple<typename CityPump_defs::start, typename CityPump_defs::level>;
+    using output_ports = tuple<typename CityPump_defs::flow>;
+    // State
+    struct state_type {
+        bool  active;
+        float flow;
+        float min_level;
+        bool wait;
+        float rate; // Flow rate last announced to the reservoir
+    };
+    state_type state;
+    // Constructors
+    ContinuousCityPump() : ContinuousCityPump(model_parameters()) {}
+    ContinuousCityPump(const model_parameters& parameters) {
+        state.active = false;
+        state.flow = parameters.city_flow; //m^3 / s
+        state.min_level = parameters.min_level;
+        state.wait = false;
+        state.rate = 0;
+    }
+    // internal transition
+    void internal_transition() {
+        state.rate = target_rate();
+    }
+    // external transition
+    void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+        const vector<int>& start = get_messages<typename CityPump_defs::start>(mbs);
+        const vector<float>& level = get_messages<typename CityPump_defs::level>(mbs);
+        if(start.size()>1 || level.size()>1) assert(false && "One message at a time");
+
+        if (start.size() > 0) {
+            state.active = start[0] == 1;
+        }
+        if (level.size() > 0) {
+            if (level[0] <= state.min_level) {
+                state.wait = true;
+            } else if (level[0] >= (state.min_level + 0.2)) {
+                state.wait = false;
+            }
+        }
+    }
+    // confluence transition
+    void confluence_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+        internal_transition();
+        external_transition(TIME(), move(mbs));
+    }
+    // output function
+    typename make_message_bags<output_ports>::type output() const {
+        typename make_message_bags<output_ports>::type bags;
+        get_messages<typename CityPump_defs::flow>(bags).push_back(volume_type(target_rate() - state.rate));
+        return bags;
+    }
+    // time_advance function
+    TIME time_advance() const {
+        if (target_rate() != state.rate) return TIME(); // Announce the new rate right away
+        return numeric_limits<TIME>::infinity();
+    }
+
+    float target_rate() const {
+        return state.active && !state.wait ? state.flow : 0;
+    }
+
+    friend ostringstream& operator<<(ostringstream& os, const typename ContinuousCityPump<TIME>::state_type& i) {
+        os << "active: " << i.active;
+        return os;
+    }
+
+    friend bool operator==(const typename ContinuousCityPump<TIME>::state_type& a, const typename ContinuousCityPump<TIME>::state_type& b) {
+        return a.active == b.active && a.flow == b.flow && a.min_level == b.min_level && a.wait == b.wait && a.rate == b.rate;
+    }
+};
+#endif // _CONTINUOUS_CITY_PUMP_HPP__
@@ -0,0 +1,125 @@
+/**
+ * Continuous (rate based) variant of the Reservoir atomic model
+ *
+ * The volume is integrated analytically from the total inflow and outflow
+ * rates. Instead of a sensor reading after every water packet, the level is
+ * only output when it reaches one of the thresholds the pumps react to, at
+ * the exact time it is reached. With constant flows the reservoir is passive.
+ * Same ports as Reservoir, flow_in and flow_out carry rate changes in m^3/s.
+**/
+
+#ifndef _CONTINUOUS_RESERVOIR_HPP__
+#define _CONTINUOUS_RESERVOIR_HPP__
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <assert.h>
+#include <string>
+#include <vector>
+
+#include "reservoir.hpp"
+#include "flow_rate.hpp"
+#include "flow_sum.hpp"
+
+using namespace cadmium;
+using namespace std;
+
+template<typename TIME> class ContinuousReservoir {
+    public:
+    // Ports
+    using input_ports  = tuple<typename Reservoir_defs::flow_in, typename Reservoir_defs::flow_out>;
+    using output_ports = tuple<typename Reservoir_defs::level>;
+    // State
+    struct state_type {
+        double volume;  // In m^3
+        double inflow;  // In m^3/s
+        double outflow; // In m^3/s
+        float surface;
+        float height;
+        double sigma;   // Seconds until the next threshold is reached
+        vector<float> thresholds; // Levels the pumps react to, sorted
+    };
+    state_type state;
+    // Constructors, the thresholds are the ones of CityPump (min_level, + 0.2) and WaterSupplyPump (max_level - 0.5, - 0.2)
+    ContinuousReservoir() : ContinuousReservoir(model_parameters()) {}
+    ContinuousReservoir(const model_parameters& parameters)
+        : ContinuousReservoir(vector<float>{parameters.min_level, parameters.min_level + 0.2f, parameters.max_level - 0.5f, parameters.max_level - 0.2f}, parameters) {}
+    ContinuousReservoir(vector<float> thresholds, const model_parameters& parameters = model_parameters()) {
+        state.volume = 1000;
+        state.inflow = 0;
+        state.outflow = 0;
+        state.surface = parameters.surface;
+        state.height = parameters.height;
+        sort(thresholds.begin(), thresholds.end());
+        state.thresholds = move(thresholds);
+        state.sigma = next_crossing();
+    }
+    // internal transition
+    void internal_transition() {
+        state.volume += (state.inflow - state.outflow) * state.sigma;
+        state.sigma = next_crossing();
+    }
+    // external transition
+    void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+        // The rate changes come in the volume type of the build, the rates are kept in double
+        const vector<volume_type>& flow_in  = get_messages<typename Reservoir_defs::flow_in>(mbs);
+        const vector<volume_type>& flow_out = get_messages<typename Reservoir_defs::flow_out>(mbs);
+        state.volume += (state.inflow - state.outflow) * time_to_seconds(e);
+        state.inflow += (double) flow_sum(flow_in);
+        state.outflow += (double) flow_sum(flow_out);
+        // Deltas of +-flow cancel exactly in float, only rounding noise is left when a total goes back to 0
+        if (abs(state.inflow) < 1e-6) state.inflow = 0;
+        if (abs(state.outflow) < 1e-6) state.outflow = 0;
+        state.sigma = next_crossing();
+        assert(state.volume <= state.height * state.surface); // Ensure reservoir is not overflowing
+    }
+    // confluence transition
+    void confluence_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+        internal_transition();
+        external_transition(TIME(), move(mbs));
+    }
+    // output function
+    typename make_message_bags<output_ports>::type output() const {
+        typename make_message_bags<output_ports>::type bags;
+        double volume = state.volume + (state.inflow - state.outflow) * state.sigma;
+        get_messages<typename Reservoir_defs::level>(bags).push_back(volume / state.surface);
+        return bags;
+    }
+    // time_advance function
+    TIME time_advance() const {
+        return seconds_to_time<TIME>(state.sigma);
+    }
+
+    // Seconds until the level reaches the next threshold in the direction it moves, infinity if it never does
+    double next_crossing() const {
+        double rate = state.inflow - state.outflow;
+        double level = state.volume / state.surface;
+        const double margin = 1e-6; // A threshold just reached does not count again
+        double target = numeric_limits<double>::quiet_NaN();
+        if (rate > 0) {
+            for (float t : state.thresholds) {
+                if (t > level + margin) { target = t; break; }
+            }
+        } else if (rate < 0) {
+            for (auto t = state.thresholds.rbegin(); t != state.thresholds.rend(); ++t) {
+                if (*t < level - margin) { target = *t; break; }
+            }
+        }
+        if (isnan(target)) return numeric_limits<double>::infinity();
+        return (target * state.surface - state.volume) / rate;
+    }
+
+    friend ostringstream& operator<<(ostringstream& os, const typename ContinuousReservoir<TIME>::state_type& i) {
+        os << "volume: " << (float) i.volume << " & level: " << (float) (i.volume / i.surface);
+        return os;
+    }
+
+    friend bool operator==(const typename ContinuousReservoir<TIME>::state_type& a, const typename ContinuousReservoir<TIME>::state_type& b) {
+        return a.volume == b.volume && a.inflow == b.inflow && a.outflow == b.outflow && a.surface == b.surface
+            && a.height == b.height && a.sigma == b.sigma && a.thresholds == b.thresholds;
+    }
+};
+#endif // _CONTINUOUS_RESERVOIR_HPP__
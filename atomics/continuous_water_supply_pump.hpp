@@ -0,0 +1,148 @@
+/**
+ * Continuous (rate based) variant of the WaterSupplyPump atomic model
+ *
+ * The pump outputs the change of its flow rate (m^3/s) when it starts, stops,
+ * waits, gets blocked or unblocked, and is passive otherwise. Blockages keep
+ * the chance of blockage_probability per 30 second period of pumping: the
+ * number of periods until the next one is drawn when the pump starts or is
+ * unblocked (in one draw, from the geometric distribution) instead of drawing
+ * at every event. Same ports and level thresholds as
+ * WaterSupplyPump.
+**/
+
+#ifndef _CONTINUOUS_WATER_SUPPLY_PUMP_HPP__
+#define _CONTINUOUS_WATER_SUPPLY_PUMP_HPP__
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+
+#include <cmath>
+#include <limits>
+#include <assert.h>
+#include <string>
+#include <random>
+
+#include "water_supply_pump.hpp"
+#include "flow_rate.hpp"
+
+using namespace cadmium;
+using namespace std;
+
+template<typename TIME> class ContinuousWaterSupplyPump {
+    public:
+    // Ports
+    using input_ports  = tuple<typename WaterSupplyPump_defs::start, typename WaterSupplyPump_defs::level>;
+    using output_ports = tuple<typename WaterSupplyPump_defs::flow>;
+    // State
+    struct state_type {
+        bool  active;
+        float flow;
+        float period;
+        bool  blockage;
+        float max_level;
+        bool wait;
+        double blockage_probability; // Chance of a blockage per period of pumping
+        TIME unblock_time;           // Time it takes to unblock
+        TIME next_change;            // Pumping time left until the next blockage, or until unblocked
+        float rate;                  // Flow rate last announced to the reservoir
+    };
+    state_type state;
+    // Random engine used for blockages, owned by the instance so runs are reproducible and thread safe
+    mt19937 rng;
+    // Constructors
+    ContinuousWaterSupplyPump() : ContinuousWaterSupplyPump(mt19937::default_seed) {}
+    ContinuousWaterSupplyPump(unsigned int seed, double blockage_probability = 0.1, TIME unblock_time = TIME("00:30:00:000"),
+                              const model_parameters& parameters = model_parameters()) : rng(seed) {
+        state.active = false;
+        state.flow = parameters.supply_flow; //m^3 / s
+        state.period = 30.0; // seconds
+        state.blockage = false;
+        state.max_level = parameters.max_level;
+        state.wait = false;
+        state.blockage_probability = blockage_probability;
+        state.unblock_time = unblock_time;
+        state.rate = 0;
+        state.next_change = time_to_blockage();
+    }
+    // internal transition
+    void internal_transition() {
+        if (target_rate() != state.rate) { // New rate announced
+            state.rate = target_rate();
+        } else if (state.blockage) {
+            state.blockage = false;
+            state.next_change = time_to_blockage();
+        } else {
+            state.blockage = true;
+            state.next_change = state.unblock_time;
+        }
+    }
+    // external transition
+    void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+        const vector<int>& start = get_messages<typename WaterSupplyPump_defs::start>(mbs);
+        const vector<float>& level = get_messages<typename WaterSupplyPump_defs::level>(mbs);
+        if(start.size()>1 || level.size()>1) assert(false && "One message at a time");
+
+        // The blockage clock only runs while pumping (or blocked while trying to)
+        if (running() && target_rate() == state.rate) {
+            state.next_change = state.next_change - e;
+        }
+        if (start.size() > 0) {
+            state.active = start[0] == 1;
+        }
+        if (level.size() > 0) {
+            if (level[0] >= (state.max_level - 0.2)) { // Stop just before the reservoir is full
+                state.wait = true;
+            } else if (level[0] <= (state.max_level - 0.5)) { // Restart pump after level drops a bit
+                state.wait = false;
+            }
+        }
+    }
+    // confluence transition
+    void confluence_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
+        internal_transition();
+        external_transition(TIME(), move(mbs));
+    }
+    // output function
+    typename make_message_bags<output_ports>::type output() const {
+        typename make_message_bags<output_ports>::type bags;
+        if (target_rate() != state.rate) {
+            get_messages<typename WaterSupplyPump_defs::flow>(bags).push_back(volume_type(target_rate() - state.rate));
+        }
+        return bags;
+    }
+    // time_advance function
+    TIME time_advance() const {
+        if (target_rate() != state.rate) return TIME(); // Announce the new rate right away
+        if (running()) return state.next_change;
+        return numeric_limits<TIME>::infinity();
+    }
+
+    bool running() const {
+        return state.active && !state.wait;
+    }
+    float target_rate() const {
+        return running() && !state.blockage ? state.flow : 0;
+    }
+    // Whole periods of pumping until the next blockage, the first one included: 1 + floor(log(u) / log(1 - p)) with u
+    // uniform in (0, 1) from the raw engine output, which has the chance p of a blockage per period without one draw each
+    TIME time_to_blockage() {
+        if (!(state.blockage_probability > 0)) return numeric_limits<TIME>::infinity();
+        if (state.blockage_probability >= 1) return seconds_to_time<TIME>(state.period);
+        double u = (rng() + 0.5) / 4294967296.0;
+        double seconds = (1 + floor(log(u) / log1p(-state.blockage_probability))) * state.period;
+        if (!(seconds < 1e9)) return numeric_limits<TIME>::infinity(); // Over 30 years of pumping, never blocks
+        return seconds_to_time<TIME>(seconds);
+    }
+
+    friend ostringstream& operator<<(ostringstream& os, const typename ContinuousWaterSupplyPump<TIME>::state_type& i) {
+        os << "active: " << i.active << " & blockage: " << i.blockage << " & waiting: " << i.wait;
+        return os;
+    }
+
+    friend bool operator==(const typename ContinuousWaterSupplyPump<TIME>::state_type& a, const typename ContinuousWaterSupplyPump<TIME>::state_type& b) {
+        return a.active == b.active && a.flow == b.flow && a.period == b.period && a.blockage == b.blockage && a.max_level == b.max_level
+            && a.wait == b.wait && a.blockage_probability == b.blockage_probability && a.unblock_time == b.unblock_time
+            && a.next_change == b.next_change && a.rate == b.rate;
+    }
+};
+#endif // _CONTINUOUS_WATER_SUPPLY_PUMP_HPP__
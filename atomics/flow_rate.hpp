@@ -0,0 +1,28 @@
+/**
+ * Helpers shared by the continuous (rate based) atomic models
+ *
+ * In the continuous mode the pumps do not send water packets: their flow
+ * ports carry the change of their flow rate in m^3/s (new rate - old rate),
+ * so the reservoir keeps the total rates by summing the messages it receives.
+**/
+
+#ifndef _FLOW_RATE_HPP__
+#define _FLOW_RATE_HPP__
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+#include "tick_time.hpp"
+
+using namespace std;
+
+// Rounded up to the millisecond so a threshold is always reached at the scheduled time (time_to_seconds() is in
+// tick_time.hpp)
+template<typename TIME> TIME seconds_to_time(double seconds) {
+    if (!isfinite(seconds)) return numeric_limits<TIME>::infinity();
+    long long ms = (long long) ceil(seconds * 1000.0 - 1e-6);
+    return ms_to_time<TIME>(ms < 0 ? 0 : ms);
+}
+#endif // _FLOW_RATE_HPP__
@@ -0,0 +1,59 @@
+/**
+ * Sum of the flow messages received by a reservoir in one bag
+ *
+ * With many pumps on one reservoir a bag holds hundreds of packets. They are
+ * added in double on 8 independent lanes combined pairwise at the end: the
+ * adds do not depend on each other so the loop vectorizes without
+ * -ffast-math, and in double the float packets of a bag add up without float
+ * rounding for the bag sizes seen here.
+ * fixed_volume packets are added as integers, exact in any order.
+**/
+
+#ifndef _FLOW_SUM_HPP__
+#define _FLOW_SUM_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "volume.hpp"
+
+using namespace std;
+
+template<typename T> double flow_sum(const vector<T>& flows) {
+    const T * f = flows.data();
+    size_t n = flows.size(), i = 0;
+    double lanes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (; i + 8 <= n; i += 8) {
+        for (int l = 0; l < 8; l++) lanes[l] += f[i + l];
+    }
+    double tail = 0;
+    for (; i < n; i++) tail += f[i];
+    return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7])) + tail;
+}
+
+inline fixed_volume flow_sum(const vector<fixed_volume>& flows) {
+    int64_t total = 0;
+    for (fixed_volume f : flows) total += f.raw();
+    return fixed_volume::from_raw(total);
+}
+
+// Volume kept as a float plus the part of the exact (double) volume the float could not hold, so
+// rounding does not build up over long runs while the float volume is what the model logs
+inline void add_volume(float& volume, double& volume_error, double delta) {
+    double exact = (double) volume + volume_error + delta;
+    volume = (float) exact;
+    volume_error = exact - volume;
+}
+// Kahan summation of the double volume, volume + volume_error is the volume as above
+inline void add_volume(double& volume, double& volume_error, double delta) {
+    double y = delta + volume_error;
+    double t = volume + y;
+    volume_error = y - (t - volume);
+    volume = t;
+}
+// Integer adds are exact, there is no error to keep (same signature so the Reservoir calls any volume type alike)
+inline void add_volume(fixed_volume& volume, [[maybe_unused]] double& volume_error, fixed_volume delta) {
+    volume += delta;
+}
+#endif // _FLOW_SUM_HPP__
@@ -0,0 +1,54 @@
+/**
+ * Runtime parameters of the City Water Supply atomic models
+ *
+ * The defaults are the constants the models always had, so a model built
+ * without parameters behaves as before. The hysteresis of the pumps around
+ * min_level and max_level (0.2 and 0.5 m) is part of the model, not a
+ * parameter.
+**/
+
+#ifndef _MODEL_PARAMETERS_HPP__
+#define _MODEL_PARAMETERS_HPP__
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct model_parameters {
+    float min_level   = 0.5;          // m, the city pumps wait below it
+    float max_level   = 5.0;          // m, the supply pumps wait from 0.2 m below it
+    float supply_flow = 0.5;          // m^3/s, of each water supply pump
+    float city_flow   = 0.4;          // m^3/s, of each city pump
+    float surface     = 10.0 * 100.0; // m^2, of each reservoir
+    float height      = 5.0;          // m, of each reservoir
+
+    // Names of the parameters, "min_level" is given as --min-level on the command line
+    static const std::vector<std::pair<std::string, float model_parameters::*>>& fields() {
+        static const std::vector<std::pair<std::string, float model_parameters::*>> all = {
+            {"min_level", &model_parameters::min_level}, {"max_level", &model_parameters::max_level},
+            {"supply_flow", &model_parameters::supply_flow}, {"city_flow", &model_parameters::city_flow},
+            {"surface", &model_parameters::surface}, {"height", &model_parameters::height}};
+        return all;
+    }
+    static std::string option(const std::string& field) {
+        std::string name = "--" + field;
+        for (char& c : name) if (c == '_') c = '-';
+        return name;
+    }
+
+    // Throws if the models could not run with these values (thresholds out of order, overflowing reservoir)
+    void check() const {
+        if (!(supply_flow >= 0 && city_flow >= 0 && surface > 0 && height > 0)) {
+            throw std::invalid_argument("Flows must not be negative, surface and height must be positive");
+        }
+        if (!(min_level >= 0 && min_level + 0.2f < max_level - 0.5f)) {
+            throw std::invalid_argument("min_level + 0.2 must be below max_level - 0.5 (min_level " + std::to_string(min_level)
+                                        + ", max_level " + std::to_string(max_level) + ")");
+        }
+        if (max_level > height) {
+            throw std::invalid_argument("max_level must not be above the reservoir height");
+        }
+    }
+};
+#endif // _MODEL_PARAMETERS_HPP__
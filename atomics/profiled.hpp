@@ -0,0 +1,140 @@
+/**
+ * Opt-in profiling of atomic models
+ *
+ * PROFILED(ATOMIC) names the atomic template to instantiate. When PROFILE_MODELS
+ * is defined it wraps ATOMIC so every call of internal_transition,
+ * external_transition, confluence_transition, output and time_advance is
+ * counted and timed per model instance; otherwise it is ATOMIC itself and the
+ * profiling compiles out completely. model_profile::report() and
+ * model_profile::write_csv() print the totals once the run is over.
+**/
+
+#ifndef _PROFILED_HPP__
+#define _PROFILED_HPP__
+
+#ifdef PROFILE_MODELS
+#define PROFILED(ATOMIC) profiled<ATOMIC>::template type
+#else
+#define PROFILED(ATOMIC) ATOMIC
+#endif
+
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+
+using namespace std;
+using namespace cadmium;
+
+struct model_profile {
+    enum call { internal, external, confluence, output, time_advance, calls };
+
+    struct entry {
+        string    model_id;
+        long long count[calls] = {};
+        long long nanoseconds[calls] = {};
+    };
+
+    // Entries are never moved, each model instance keeps a pointer to its own
+    static entry * add(const string& model_id) {
+        lock_guard<mutex> lock(registry_mutex);
+        entries.emplace_back();
+        entries.back().model_id = model_id;
+        return &entries.back();
+    }
+
+    static void report(ostream& os) {
+        lock_guard<mutex> lock(registry_mutex);
+        os << left << setw(24) << "model";
+        for (int c = 0; c < calls; c++) os << right << setw(14) << call_names[c] << setw(12) << "ms";
+        os << endl;
+        for (const entry& e : entries) {
+            os << left << setw(24) << e.model_id << fixed << setprecision(3);
+            for (int c = 0; c < calls; c++) os << right << setw(14) << e.count[c] << setw(12) << e.nanoseconds[c] / 1e6;
+            os << endl;
+        }
+        os.unsetf(ios::floatfield);
+    }
+
+    static void write_csv(const string& path) {
+        lock_guard<mutex> lock(registry_mutex);
+        ofstream out(path);
+        out << "model,call,count,nanoseconds" << endl;
+        for (const entry& e : entries) {
+            for (int c = 0; c < calls; c++) out << e.model_id << "," << call_names[c] << "," << e.count[c] << "," << e.nanoseconds[c] << endl;
+        }
+    }
+
+    static inline const char * call_names[calls] = {"internal", "external", "confluence", "output", "time_advance"};
+    static inline deque<entry> entries;
+    static inline mutex registry_mutex;
+};
+
+template<template<typename> class ATOMIC> struct profiled {
+    template<typename TIME> class type : public ATOMIC<TIME> {
+        using clock = chrono::steady_clock;
+        using base = ATOMIC<TIME>;
+        mutable model_profile::entry * profile = nullptr;
+
+        // The id is only known once the model is fully built: the dynamic id, else the type name (static models)
+        model_profile::entry * entry() const {
+            if (profile) return profile;
+            if (auto model = dynamic_cast<const dynamic::modeling::model *>(this)) {
+                profile = model_profile::add(model->get_id());
+            } else {
+                int status;
+                char * name = abi::__cxa_demangle(typeid(*this).name(), nullptr, nullptr, &status);
+                profile = model_profile::add(status == 0 ? name : typeid(*this).name());
+                free(name);
+            }
+            return profile;
+        }
+        void record(model_profile::call c, clock::time_point start) const {
+            model_profile::entry * e = entry();
+            e->count[c]++;
+            e->nanoseconds[c] += chrono::duration_cast<chrono::nanoseconds>(clock::now() - start).count();
+        }
+    public:
+        using base::base;
+        type() = default;
+        virtual ~type() = default;
+
+        void internal_transition() {
+            auto start = clock::now();
+            base::internal_transition();
+            record(model_profile::internal, start);
+        }
+        void external_transition(TIME e, typename make_message_bags<typename base::input_ports>::type mbs) {
+            auto start = clock::now();
+            base::external_transition(e, move(mbs));
+            record(model_profile::external, start);
+        }
+        void confluence_transition(TIME e, typename make_message_bags<typename base::input_ports>::type mbs) {
+            auto start = clock::now();
+            base::confluence_transition(e, move(mbs));
+            record(model_profile::confluence, start);
+        }
+        typename make_message_bags<typename base::output_ports>::type output() const {
+            auto start = clock::now();
+            typename make_message_bags<typename base::output_ports>::type bags = base::output();
+            record(model_profile::output, start);
+            return bags;
+        }
+        TIME time_advance() const {
+            auto start = clock::now();
+            TIME next_internal = base::time_advance();
+            record(model_profile::time_advance, start);
+            return next_internal;
+        }
+    };
+};
+#endif // _PROFILED_HPP__
@@ -17,35 +17,51 @@
 #include <string>
 #include <random>
 
+#include "model_parameters.hpp"
+#include "flow_sum.hpp"
+#include "volume.hpp"
+#include "tick_time.hpp"
+
 using namespace cadmium;
 using namespace std;
 
-// Port Definition
+// Port Definition, the flows are volumes of water (see volume.hpp)
 struct Reservoir_defs {
-    struct flow_out : public in_port<float> {};
-    struct flow_in : public in_port<float> {};
+    struct flow_out : public in_port<volume_type> {};
+    struct flow_in : public in_port<volume_type> {};
+    struct level : public out_port<float> {};
+};
+// Ports of a Reservoir with another volume type than the build's, the port names show in the message logs
+template<typename VOLUME> struct Reservoir_defs_of {
+    struct flow_out : public in_port<VOLUME> {};
+    struct flow_in : public in_port<VOLUME> {};
     struct level : public out_port<float> {};
 };
+template<> struct Reservoir_defs_of<volume_type> : public Reservoir_defs {};
 
-template<typename TIME> class Reservoir {
+template<typename TIME, typename VOLUME = volume_type> class Reservoir {
+    using defs = Reservoir_defs_of<VOLUME>;
     public:
     // Ports
-    using input_ports  = tuple<typename Reservoir_defs::flow_in, typename Reservoir_defs::flow_out>;
-    using output_ports = tuple<typename Reservoir_defs::level>;
+    using input_ports  = tuple<typename defs::flow_in, typename defs::flow_out>;
+    using output_ports = tuple<typename defs::level>;
     // State
     struct state_type {
-        float volume; // In m^3
+        VOLUME volume; // In m^3
+        double volume_error; // Rounding of volume, carried to the next transition
         bool reading;
         float surface;
         float height;
     };
     state_type state;
-    // Constructor
-    Reservoir() {
+    // Constructors
+    Reservoir() : Reservoir(model_parameters()) {}
+    Reservoir(const model_parameters& parameters) {
         state.volume = 1000;
+        state.volume_error = 0;
         state.reading = false;
-        state.surface = 10.0 * 100.0;
-        state.height = 5.0;
+        state.surface = parameters.surface;
+        state.height = parameters.height;
     }
     // internal transition
     void internal_transition() { 
@@ -53,23 +69,13 @@ template<typename TIME> class Reservoir {
     }
     // external transition
     void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) { 
-        vector<float> flow_in;
-        vector<float> flow_out;
-        flow_in  = get_messages<typename Reservoir_defs::flow_in>(mbs);
-        flow_out = get_messages<typename Reservoir_defs::flow_out>(mbs);
+        // References into the bags, copying them would allocate on every event
+        const vector<VOLUME>& flow_in  = get_messages<typename defs::flow_in>(mbs);
+        const vector<VOLUME>& flow_out = get_messages<typename defs::flow_out>(mbs);
         // if(flow_in.size()>1 || flow_out.size()>1) assert(false && "One message at a time");               
         state.reading = true;
         // Can handle multiple arrive and departure of water packets
-        if (flow_in.size() > 0) {
-            for (int i = 0; i < flow_in.size(); i++) {
-                state.volume += flow_in[i];
-            }
-        }
-        if (flow_out.size() > 0) {
-            for (int i = 0; i < flow_out.size(); i++) {
-                state.volume -= flow_out[i];
-            }
-        }
+        add_volume(state.volume, state.volume_error, flow_sum(flow_in) - flow_sum(flow_out));
         assert(state.volume <= state.height * state.surface); // Ensure reservoir is not overflowing
     }
     // confluence transition
@@ -80,25 +86,28 @@ template<typename TIME> class Reservoir {
     // output function
     typename make_message_bags<output_ports>::type output() const {
         typename make_message_bags<output_ports>::type bags;
-        vector<float> level;            
-        level.push_back(state.volume / state.surface);
-        get_messages<typename Reservoir_defs::level>(bags) = level;
+        // Written straight into the bag, its storage is the only allocation of the output
+        get_messages<typename defs::level>(bags).push_back(volume_level(state.volume, state.surface));
         return bags;
     }
     // time_advance function
     TIME time_advance() const {
         TIME next_internal;
         if (state.reading) {            
-            next_internal = TIME("00:00:03:000"); // Water level sensor reading time
+            next_internal = model_durations<TIME>::sensor(); // Water level sensor reading time
         } else {
             next_internal = numeric_limits<TIME>::infinity();
         }    
         return next_internal;
     }
 
-    friend ostringstream& operator<<(ostringstream& os, const typename Reservoir<TIME>::state_type& i) {
-        os << "volume: " << i.volume << " & level: " << i.volume / i.surface; 
+    friend ostringstream& operator<<(ostringstream& os, const typename Reservoir<TIME, VOLUME>::state_type& i) {
+        os << "volume: " << i.volume << " & level: " << volume_level(i.volume, i.surface);
         return os;
     }
+
+    friend bool operator==(const typename Reservoir<TIME, VOLUME>::state_type& a, const typename Reservoir<TIME, VOLUME>::state_type& b) {
+        return a.volume == b.volume && a.volume_error == b.volume_error && a.reading == b.reading && a.surface == b.surface && a.height == b.height;
+    }
 };
 #endif // _RESERVOIR_HPP__
@@ -0,0 +1,157 @@
+/**
+ * Time type of the simulation: an integer count of milliseconds
+ *
+ * The models only ever schedule whole milliseconds (30 s packets, 3 s sensor
+ * readings, input times, rates rounded up to the ms), so tick_time keeps the
+ * time in one int64 and the runner's scheduling becomes integer adds and
+ * compares. It reads and prints the same "hh:mm:ss:mmm" text as NDTime, so
+ * input files, logs and checkpoints are the same with either type.
+ *
+ * time_type is the one of the build: NDTime by default, tick_time with
+ * -DTICK_TIME (make TIME=tick).
+**/
+
+#ifndef _TICK_TIME_HPP__
+#define _TICK_TIME_HPP__
+
+#include <NDTime.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <istream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+class tick_time {
+    int64_t ticks; // ms, infinity is the largest value
+public:
+    static constexpr int64_t infinite_ticks = numeric_limits<int64_t>::max();
+
+    constexpr tick_time() : ticks(0) {}
+    // {hours, minutes, seconds, milliseconds}, like NDTime
+    tick_time(initializer_list<int> fields) : ticks(0) {
+        const int64_t scale[] = {3600000, 60000, 1000, 1};
+        int i = 0;
+        for (int field : fields) {
+            if (i < 4) ticks += field * scale[i++];
+        }
+    }
+    tick_time(const char * text) : ticks(parse(text)) {}
+    tick_time(const string& text) : ticks(parse(text.c_str())) {}
+
+    static constexpr tick_time from_ms(int64_t ms) {
+        tick_time t;
+        t.ticks = ms;
+        return t;
+    }
+    constexpr int64_t ms() const { return ticks; }
+    constexpr bool infinite() const { return ticks == infinite_ticks; }
+
+    // Infinity absorbs any time, on either side, like NDTime; sums past the largest time are infinite too
+    friend constexpr tick_time operator+(tick_time a, tick_time b) {
+        return from_ms(a.infinite() || b.infinite() || a.ticks > infinite_ticks - b.ticks ? infinite_ticks : a.ticks + b.ticks);
+    }
+    friend constexpr tick_time operator-(tick_time a, tick_time b) {
+        return from_ms(a.infinite() || b.infinite() ? infinite_ticks : a.ticks - b.ticks);
+    }
+    tick_time& operator+=(tick_time o) { return *this = *this + o; }
+    tick_time& operator-=(tick_time o) { return *this = *this - o; }
+    friend constexpr bool operator==(tick_time a, tick_time b) { return a.ticks == b.ticks; }
+    friend constexpr bool operator!=(tick_time a, tick_time b) { return a.ticks != b.ticks; }
+    friend constexpr bool operator<(tick_time a, tick_time b) { return a.ticks < b.ticks; }
+    friend constexpr bool operator<=(tick_time a, tick_time b) { return a.ticks <= b.ticks; }
+    friend constexpr bool operator>(tick_time a, tick_time b) { return a.ticks > b.ticks; }
+    friend constexpr bool operator>=(tick_time a, tick_time b) { return a.ticks >= b.ticks; }
+
+    friend ostream& operator<<(ostream& os, tick_time t) {
+        if (t.infinite()) return os << "inf";
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%02lld:%02lld:%02lld:%03lld", (long long) (t.ticks / 3600000),
+                 (long long) (t.ticks / 60000 % 60), (long long) (t.ticks / 1000 % 60), (long long) (t.ticks % 1000));
+        return os << buffer;
+    }
+    friend istream& operator>>(istream& is, tick_time& t) {
+        string text;
+        if (is >> text) t.ticks = parse(text.c_str());
+        return is;
+    }
+
+    // "hh[:mm[:ss[:mmm]]]", or "inf", throws on anything else
+    static int64_t parse(const char * text) {
+        if (string(text) == "inf") return infinite_ticks;
+        long long h = 0, m = 0, s = 0, ms = 0;
+        int fields = sscanf(text, "%lld:%lld:%lld:%lld", &h, &m, &s, &ms);
+        if (fields < 1 || strspn(text, "0123456789:") != strlen(text)) throw invalid_argument("Cannot parse time " + string(text));
+        return ((h * 60 + m) * 60 + s) * 1000 + ms;
+    }
+};
+
+namespace std {
+    template<> class numeric_limits<tick_time> {
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool has_infinity = true;
+        static constexpr tick_time infinity() { return tick_time::from_ms(tick_time::infinite_ticks); }
+        static constexpr tick_time max() { return tick_time::from_ms(tick_time::infinite_ticks - 1); }
+        static constexpr tick_time min() { return tick_time(); }
+        static constexpr tick_time lowest() { return tick_time(); }
+    };
+}
+
+#ifdef TICK_TIME
+using time_type = tick_time;
+#else
+using time_type = NDTime;
+#endif
+
+// Constant durations of the atomic models, built once instead of parsed from text at every time_advance()
+template<typename TIME> struct model_durations {
+    static const TIME& packet() { static const TIME t("00:00:30:000"); return t; } // Time between two packets of water of a pump
+    static const TIME& sensor() { static const TIME t("00:00:03:000"); return t; } // Water level sensor reading time of the reservoir
+};
+template<> struct model_durations<tick_time> {
+    static constexpr tick_time packet() { return tick_time::from_ms(30000); }
+    static constexpr tick_time sensor() { return tick_time::from_ms(3000); }
+};
+
+/****** Whole milliseconds of a time, infinite_ms for infinity *******************/
+// tick_time holds them, NDTime only gives them through its text form, read back here; the models, loggers and
+// checkpoints all convert times with these
+constexpr int64_t infinite_ms = tick_time::infinite_ticks;
+
+template<typename TIME> int64_t time_to_ms(const TIME& t) {
+    if (t == numeric_limits<TIME>::infinity()) return infinite_ms;
+    ostringstream oss;
+    oss << t;
+    long long h = 0, m = 0, s = 0, ms = 0;
+    sscanf(oss.str().c_str(), "%lld:%lld:%lld:%lld", &h, &m, &s, &ms);
+    return ((h * 60 + m) * 60 + s) * 1000 + ms;
+}
+inline int64_t time_to_ms(const tick_time& t) {
+    return t.ms();
+}
+
+template<typename TIME> TIME ms_to_time(int64_t ms) {
+    if (ms == infinite_ms) return numeric_limits<TIME>::infinity();
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%02lld:%02lld:%02lld:%03lld", (long long) (ms / 3600000),
+             (long long) (ms / 60000 % 60), (long long) (ms / 1000 % 60), (long long) (ms % 1000));
+    return TIME(buffer);
+}
+template<> inline tick_time ms_to_time<tick_time>(int64_t ms) {
+    return tick_time::from_ms(ms);
+}
+
+// Seconds of a time, infinity for an infinite one
+template<typename TIME> double time_to_seconds(const TIME& t) {
+    int64_t ms = time_to_ms(t);
+    return ms == infinite_ms ? numeric_limits<double>::infinity() : ms / 1000.0;
+}
+#endif // _TICK_TIME_HPP__
@@ -0,0 +1,68 @@
+/**
+ * Numeric type of the water volumes: reservoir volume and flow packets
+ *
+ * Reservoir, CityPump and WaterSupplyPump take it as a template parameter.
+ * volume_type is the one of the build: float by default, double with
+ * -DVOLUME_DOUBLE, or fixed_volume with -DVOLUME_FIXED. fixed_volume counts
+ * cm^3 in an int64, so packets add up exactly and the mass balance of a run
+ * closes to the cm^3 whatever its length.
+**/
+
+#ifndef _VOLUME_HPP__
+#define _VOLUME_HPP__
+
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+using namespace std;
+
+class fixed_volume {
+    int64_t units; // cm^3
+public:
+    static constexpr double units_per_m3 = 1e6;
+
+    fixed_volume() : units(0) {}
+    fixed_volume(double m3) : units(llround(m3 * units_per_m3)) {}
+    explicit operator double() const { return units / units_per_m3; }
+    int64_t raw() const { return units; }
+    static fixed_volume from_raw(int64_t units) {
+        fixed_volume v;
+        v.units = units;
+        return v;
+    }
+
+    fixed_volume& operator+=(fixed_volume o) { units += o.units; return *this; }
+    fixed_volume& operator-=(fixed_volume o) { units -= o.units; return *this; }
+    friend fixed_volume operator+(fixed_volume a, fixed_volume b) { return a += b; }
+    friend fixed_volume operator-(fixed_volume a, fixed_volume b) { return a -= b; }
+    friend fixed_volume operator-(fixed_volume a) { return from_raw(-a.units); }
+    friend bool operator==(fixed_volume a, fixed_volume b) { return a.units == b.units; }
+    friend bool operator!=(fixed_volume a, fixed_volume b) { return a.units != b.units; }
+    friend bool operator<(fixed_volume a, fixed_volume b) { return a.units < b.units; }
+    friend bool operator<=(fixed_volume a, fixed_volume b) { return a.units <= b.units; }
+    friend bool operator>(fixed_volume a, fixed_volume b) { return a.units > b.units; }
+    friend bool operator>=(fixed_volume a, fixed_volume b) { return a.units >= b.units; }
+
+    // Logged and read (input files) in m^3, like the floating point volumes
+    friend ostream& operator<<(ostream& os, fixed_volume v) { return os << (double) v; }
+    friend istream& operator>>(istream& is, fixed_volume& v) {
+        double m3;
+        if (is >> m3) v = fixed_volume(m3);
+        return is;
+    }
+};
+
+#if defined(VOLUME_FIXED)
+using volume_type = fixed_volume;
+#elif defined(VOLUME_DOUBLE)
+using volume_type = double;
+#else
+using volume_type = float;
+#endif
+
+// Level of a reservoir, computed in the volume type (float / float in the default build)
+template<typename VOLUME> float volume_level(VOLUME volume, float surface) { return volume / surface; }
+inline float volume_level(fixed_volume volume, float surface) { return (double) volume / surface; }
+#endif // _VOLUME_HPP__
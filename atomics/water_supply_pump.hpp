@@ -14,24 +14,54 @@
 
 #include <limits>
 #include <assert.h>
+#include <cstdint>
 #include <string>
 #include <random>
+#include <stdexcept>
+
+#include "model_parameters.hpp"
+#include "volume.hpp"
+#include "tick_time.hpp"
 
 using namespace cadmium;
 using namespace std;
 
-// Port Definition
+// Port Definition, the flow packets are volumes of water (see volume.hpp)
 struct WaterSupplyPump_defs {
     struct start : public in_port<int> {};
     struct level : public in_port<float> {};
-    struct flow  : public out_port<float> {};
+    struct flow  : public out_port<volume_type> {};
 };
+// Ports of a pump with another volume type than the build's, the port names show in the message logs
+template<typename VOLUME> struct WaterSupplyPump_defs_of {
+    struct start : public in_port<int> {};
+    struct level : public in_port<float> {};
+    struct flow  : public out_port<VOLUME> {};
+};
+template<> struct WaterSupplyPump_defs_of<volume_type> : public WaterSupplyPump_defs {};
+
+// Throws unless 0 <= probability <= 1, for the values given on the command line
+inline void check_blockage_probability(double probability) {
+    if (!(probability >= 0 && probability <= 1)) {
+        throw invalid_argument("Blockage probability must be between 0 and 1 (" + to_string(probability) + ")");
+    }
+}
+
+// One blockage draw: true with the given probability. Compares the engine's raw 32 bit output instead of going
+// through a standard distribution, whose algorithm differs between standard libraries, so a seed gives the same
+// blockages with every toolchain. Probabilities below 2^-32 never block.
+inline bool draw_blockage(mt19937& rng, double probability) {
+    if (probability >= 1) return true;
+    if (!(probability > 0)) return false;
+    return rng() < (uint64_t) (probability * 4294967296.0);
+}
 
-template<typename TIME> class WaterSupplyPump {
+template<typename TIME, typename VOLUME = volume_type> class WaterSupplyPump {
+    using defs = WaterSupplyPump_defs_of<VOLUME>;
     public:
     // Ports
-    using input_ports  = tuple<typename WaterSupplyPump_defs::start, typename WaterSupplyPump_defs::level>;
-    using output_ports = tuple<typename WaterSupplyPump_defs::flow>;
+    using input_ports  = tuple<typename defs::start, typename defs::level>;
+    using output_ports = tuple<typename defs::flow>;
     // State
     struct state_type {
         bool  active;
@@ -40,16 +70,24 @@ template<typename TIME> class WaterSupplyPump {
         bool  blockage;
         float max_level;
         bool wait;
+        double blockage_probability; // Chance of a blockage at each external event
+        TIME unblock_time;           // Time it takes to unblock
     };
     state_type state;
-    // Constructor
-    WaterSupplyPump() {
+    // Random engine used for blockages, owned by the instance so runs are reproducible and thread safe
+    mt19937 rng;
+    // Constructors
+    WaterSupplyPump() : WaterSupplyPump(mt19937::default_seed) {}
+    WaterSupplyPump(unsigned int seed, double blockage_probability = 0.1, TIME unblock_time = TIME("00:30:00:000"),
+                    const model_parameters& parameters = model_parameters()) : rng(seed) {
         state.active = false;
-        state.flow = 0.5; //m^3 / s
+        state.flow = parameters.supply_flow; //m^3 / s
         state.period = 30.0; // seconds
         state.blockage = false;
-        state.max_level = 5.0;
+        state.max_level = parameters.max_level;
         state.wait = false;
+        state.blockage_probability = blockage_probability;
+        state.unblock_time = unblock_time;
     }
     // internal transition
     void internal_transition() { 
@@ -59,8 +97,8 @@ template<typename TIME> class WaterSupplyPump {
     }
     // external transition
     void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
-        vector<int> start = get_messages<typename WaterSupplyPump_defs::start>(mbs);
-        vector<float> level = get_messages<typename WaterSupplyPump_defs::level>(mbs);
+        const vector<int>& start = get_messages<typename defs::start>(mbs);
+        const vector<float>& level = get_messages<typename defs::level>(mbs);
         if(start.size()>1 || level.size()>1) assert(false && "One message at a time");               
         
         if (start.size() > 0) {
@@ -78,11 +116,7 @@ template<typename TIME> class WaterSupplyPump {
             }
         }
         // Chance to generate blockage in water supply pipes
-        if ((double)rand() / (double) RAND_MAX  < 0.9){                
-            state.blockage = false;
-        }else{
-            state.blockage = true;
-        }  
+        state.blockage = draw_blockage(rng, state.blockage_probability);
     }
     // confluence transition
     void confluence_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
@@ -92,9 +126,7 @@ template<typename TIME> class WaterSupplyPump {
     // output function
     typename make_message_bags<output_ports>::type output() const {
         typename make_message_bags<output_ports>::type bags;
-        vector<float> flow;            
-        flow.push_back(state.flow * state.period);
-        get_messages<typename WaterSupplyPump_defs::flow>(bags) = flow;
+        get_messages<typename defs::flow>(bags).push_back(VOLUME(state.flow * state.period));
         return bags;
     }
     // time_advance function
@@ -102,9 +134,9 @@ template<typename TIME> class WaterSupplyPump {
         TIME next_internal;
         if (state.active && !state.wait) {
             if (state.blockage) {            
-                next_internal = TIME("00:30:00:000"); // Time it takes to unblock
+                next_internal = state.unblock_time; // Time it takes to unblock
             } else {
-                next_internal = TIME("00:00:30:000"); // Time until next packet of water
+                next_internal = model_durations<TIME>::packet(); // Time until next packet of water
             }    
         } else {
             next_internal = numeric_limits<TIME>::infinity();
@@ -112,9 +144,14 @@ template<typename TIME> class WaterSupplyPump {
         return next_internal;
     }
 
-    friend ostringstream& operator<<(ostringstream& os, const typename WaterSupplyPump<TIME>::state_type& i) {
+    friend ostringstream& operator<<(ostringstream& os, const typename WaterSupplyPump<TIME, VOLUME>::state_type& i) {
         os << "active: " << i.active << " & blockage: " << i.blockage << " & waiting: " << i.wait; 
         return os;
     }
+
+    friend bool operator==(const typename WaterSupplyPump<TIME, VOLUME>::state_type& a, const typename WaterSupplyPump<TIME, VOLUME>::state_type& b) {
+        return a.active == b.active && a.flow == b.flow && a.period == b.period && a.blockage == b.blockage && a.max_level == b.max_level
+            && a.wait == b.wait && a.blockage_probability == b.blockage_probability && a.unblock_time == b.unblock_time;
+    }
 };
 #endif // _WATER_SUPPLY_PUMP__
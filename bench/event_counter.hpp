@@ -0,0 +1,32 @@
+/**
+ * Cadmium logger counting simulation steps (one global time per step) and
+ * model outputs (one per imminent atomic model), used by the benchmarks
+ * instead of writing logs.
+**/
+
+#ifndef _EVENT_COUNTER_HPP__
+#define _EVENT_COUNTER_HPP__
+
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <type_traits>
+
+using namespace std;
+using namespace cadmium;
+
+struct event_counter {
+    static inline long long steps = 0;
+    static inline long long outputs = 0;
+
+    static void reset() {
+        steps = 0;
+        outputs = 0;
+    }
+
+    template<typename DECLARED_SOURCE, typename... FORMATS, typename... PARAMs>
+    static void log(const PARAMs&... ps) {
+        if (is_same<DECLARED_SOURCE, logger::logger_global_time>::value) steps++;
+        if (is_same<DECLARED_SOURCE, logger::logger_messages>::value) outputs++;
+    }
+};
+#endif // _EVENT_COUNTER_HPP__
@@ -0,0 +1,112 @@
+/**
+ * Counts heap allocations per call of the atomic models' transitions and
+ * outputs (global operator new is replaced by a counting one). External
+ * transitions must not allocate at all; an output allocates only the storage
+ * of the message bag it returns, which belongs to Cadmium's message_bag.
+ * Exits with 1 when an atomic goes over that budget.
+**/
+
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Atomic and coupled model headers
+#include "../atomics/reservoir.hpp"
+#include "../atomics/water_supply_pump.hpp"
+#include "../atomics/city_pump.hpp"
+#include "../top_model/city_supply.hpp"
+#include "event_counter.hpp"
+
+//C++ headers
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+using TIME = time_type;
+
+static atomic<long long> allocations{0};
+
+void * operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void * p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+// Not inlined, otherwise GCC sees free() on a pointer from operator new and warns of a mismatched deallocation
+[[gnu::noinline]] void operator delete(void * p) noexcept { free(p); }
+[[gnu::noinline]] void operator delete(void * p, size_t) noexcept { free(p); }
+
+const long long calls = 10000;
+bool within_budget = true;
+
+// Runs body calls times after a warm up call and reports the allocations per call
+template<typename BODY>
+void check(const string& name, long long budget, BODY body) {
+    body();
+    long long before = allocations.load();
+    for (long long i = 0; i < calls; i++) body();
+    double per_call = double(allocations.load() - before) / calls;
+    bool ok = per_call <= budget;
+    within_budget = within_budget && ok;
+    cout << left << setw(44) << name << right << setw(10) << per_call << setw(10) << budget << setw(6) << (ok ? "ok" : "FAIL") << endl;
+}
+
+// External transitions take their bags by value and the engine moves them in, so the bags are copied before counting
+template<typename ATOMIC, typename BAGS>
+void check_external(const string& name, ATOMIC& model, const TIME& e, const BAGS& bags) {
+    vector<BAGS> inputs(calls + 1, bags);
+    long long i = 0;
+    check(name, 0, [&]() { model.external_transition(e, move(inputs[i++])); });
+}
+
+int main(int argc, char ** argv) {
+    const char * pumps_input  = argc > 1 ? argv[1] : "../input_data/city_pump_instr.txt";
+    const char * supply_input = argc > 2 ? argv[2] : "../input_data/water_supply_instr.txt";
+    // TIME values built once, constructing them from strings is not what is measured here
+    const TIME sensor_e("00:00:03:000"), packet_e("00:00:30:000");
+
+    cout << left << setw(44) << "call" << right << setw(10) << "allocs" << setw(10) << "budget" << endl;
+
+    Reservoir<TIME> reservoir;
+    typename make_message_bags<Reservoir<TIME>::input_ports>::type reservoir_in;
+    get_messages<typename Reservoir_defs::flow_in>(reservoir_in) = vector<volume_type>(64, 15.0);
+    get_messages<typename Reservoir_defs::flow_out>(reservoir_in) = vector<volume_type>(64, 15.0);
+    check_external("Reservoir::external_transition/64", reservoir, packet_e, reservoir_in);
+    check("Reservoir::output", 1, [&]() { reservoir.output(); });
+
+    WaterSupplyPump<TIME> supply(1);
+    typename make_message_bags<WaterSupplyPump<TIME>::input_ports>::type supply_in;
+    get_messages<typename WaterSupplyPump_defs::start>(supply_in).push_back(1);
+    get_messages<typename WaterSupplyPump_defs::level>(supply_in).push_back(2.5);
+    check_external("WaterSupplyPump::external_transition", supply, sensor_e, supply_in);
+    check("WaterSupplyPump::output", 1, [&]() { supply.output(); });
+
+    CityPump<TIME> pump;
+    typename make_message_bags<CityPump<TIME>::input_ports>::type pump_in;
+    get_messages<typename CityPump_defs::start>(pump_in).push_back(1);
+    get_messages<typename CityPump_defs::level>(pump_in).push_back(2.5);
+    check_external("CityPump::external_transition", pump, sensor_e, pump_in);
+    check("CityPump::output", 1, [&]() { pump.output(); });
+
+    // Whole model, for reference: most of these come from the engine routing the bags
+    event_counter::reset();
+    long long before = allocations.load();
+    shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_city_supply<TIME>(pumps_input, supply_input);
+    dynamic::engine::runner<TIME, event_counter> r(TOP, {0});
+    r.run_until(TIME("24:00:00:000"));
+    cout << "TOP 24h: " << allocations.load() - before << " allocations for " << event_counter::steps << " steps" << endl;
+
+    return within_budget ? 0 : 1;
+}
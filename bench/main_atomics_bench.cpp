@@ -0,0 +1,217 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Atomic and coupled model headers
+#include "../atomics/reservoir.hpp"
+#include "../atomics/water_supply_pump.hpp"
+#include "../atomics/city_pump.hpp"
+#include "../top_model/city_supply.hpp"
+#include "event_counter.hpp"
+#include "microbench.hpp"
+
+//C++ headers
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+using TIME = time_type;
+
+/****** Reservoir external transition with bags of n inflows and n outflows, volumes of the build or of the given type *******************/
+template<typename VOLUME = volume_type>
+void reservoir_external(benchmark_state& state, int n) {
+    Reservoir<TIME, VOLUME> reservoir;
+    typename make_message_bags<typename Reservoir<TIME, VOLUME>::input_ports>::type mbs;
+    // Same volume in and out so the reservoir never overflows
+    get_messages<typename Reservoir_defs_of<VOLUME>::flow_in>(mbs) = vector<VOLUME>(n, 15.0);
+    get_messages<typename Reservoir_defs_of<VOLUME>::flow_out>(mbs) = vector<VOLUME>(n, 15.0);
+    for (long long i = 0; i < state.iterations; i++) {
+        reservoir.external_transition(TIME("00:00:30:000"), mbs);
+        do_not_optimize(reservoir.state.volume);
+    }
+    state.items = state.iterations * 2 * n;
+}
+
+/****** Sum of a bag of n flows: one float add after the other (the Reservoir before flow_sum) or flow_sum *******************/
+float sequential_sum(const vector<float>& flows) {
+    float total = 0;
+    for (size_t i = 0; i < flows.size(); i++) total += flows[i];
+    return total;
+}
+
+void flow_bag_sum(benchmark_state& state, int n, bool lanes) {
+    vector<float> flows(n);
+    for (int i = 0; i < n; i++) flows[i] = 12.0f + (i % 7) * 0.37f;
+    for (long long i = 0; i < state.iterations; i++) {
+        do_not_optimize(flows);
+        if (lanes) do_not_optimize(flow_sum(flows));
+        else do_not_optimize(sequential_sum(flows));
+    }
+    state.items = state.iterations * n;
+}
+
+/****** Volume error after a number of days of 30 s steps (3 packets of 9.4 in, 2 of 14.1 out), against the exact sum of the packets *******************/
+void print_volume_drift(int days) {
+    vector<float> flow_in(3, 9.4f), flow_out(2, 14.1f);
+    float sequential = 1000;
+    float volume = 1000;
+    double volume_error = 0;
+    double exact = 1000;
+    for (long long step = 0; step < days * 2880LL; step++) {
+        for (float f : flow_in) sequential += f;
+        for (float f : flow_out) sequential -= f;
+        add_volume(volume, volume_error, flow_sum(flow_in) - flow_sum(flow_out));
+        for (float f : flow_in) exact += f;
+        for (float f : flow_out) exact -= f;
+    }
+    cout << "volume error after " << days << " days: float adds " << fabs(sequential - exact) << " m^3, flow_sum + add_volume "
+         << fabs(volume + volume_error - exact) << " m^3 (float volume " << fabs(volume - exact) << " m^3)" << endl;
+}
+
+/****** Mass balance of a Reservoir<TIME, VOLUME> after a number of days of 30 s steps (3 packets of 9.4 m^3 in, 2 of 14.1 out, so no change) *******************/
+template<typename VOLUME>
+void print_mass_balance(const string& name, int days) {
+    Reservoir<TIME, VOLUME> reservoir;
+    for (long long step = 0; step < days * 2880LL; step++) {
+        typename make_message_bags<typename Reservoir<TIME, VOLUME>::input_ports>::type mbs;
+        get_messages<typename Reservoir_defs_of<VOLUME>::flow_in>(mbs) = vector<VOLUME>(3, 9.4);
+        get_messages<typename Reservoir_defs_of<VOLUME>::flow_out>(mbs) = vector<VOLUME>(2, 14.1);
+        reservoir.external_transition(TIME("00:00:30:000"), move(mbs));
+    }
+    cout << "mass balance error after " << days << " days, " << name << " volumes: " << fabs((double) reservoir.state.volume - 1000.0) << " m^3" << endl;
+}
+
+/****** Water supply pump external transition, level reading and blockage draw *******************/
+void supply_pump_external(benchmark_state& state) {
+    WaterSupplyPump<TIME> pump(1);
+    typename make_message_bags<WaterSupplyPump<TIME>::input_ports>::type mbs;
+    get_messages<typename WaterSupplyPump_defs::level>(mbs).push_back(2.5);
+    for (long long i = 0; i < state.iterations; i++) {
+        pump.external_transition(TIME("00:00:03:000"), mbs);
+        do_not_optimize(pump.state.blockage);
+    }
+    state.items = state.iterations;
+}
+
+/****** City pump output *******************/
+void city_pump_output(benchmark_state& state) {
+    CityPump<TIME> pump;
+    for (long long i = 0; i < state.iterations; i++) {
+        typename make_message_bags<CityPump<TIME>::output_ports>::type bags = pump.output();
+        do_not_optimize(get_messages<typename CityPump_defs::flow>(bags)[0]);
+    }
+    state.items = state.iterations;
+}
+
+/****** Round trip of a PumpStation step: n city pump outputs routed into the reservoir bag, reservoir output routed back *******************/
+void message_bags_round_trip(benchmark_state& state, int n) {
+    vector<CityPump<TIME>> pumps(n);
+    Reservoir<TIME> reservoir;
+    for (long long i = 0; i < state.iterations; i++) {
+        typename make_message_bags<Reservoir<TIME>::input_ports>::type reservoir_in;
+        for (const CityPump<TIME>& pump : pumps) {
+            typename make_message_bags<CityPump<TIME>::output_ports>::type out = pump.output();
+            for (volume_type flow : get_messages<typename CityPump_defs::flow>(out)) {
+                get_messages<typename Reservoir_defs::flow_out>(reservoir_in).push_back(flow);
+            }
+        }
+        // Refill what was pumped out, as the supply pumps would
+        get_messages<typename Reservoir_defs::flow_in>(reservoir_in) = get_messages<typename Reservoir_defs::flow_out>(reservoir_in);
+        reservoir.external_transition(TIME("00:00:30:000"), move(reservoir_in));
+        typename make_message_bags<Reservoir<TIME>::output_ports>::type level = reservoir.output();
+        for (CityPump<TIME>& pump : pumps) {
+            typename make_message_bags<CityPump<TIME>::input_ports>::type pump_in;
+            get_messages<typename CityPump_defs::level>(pump_in) = get_messages<typename Reservoir_defs::level>(level);
+            pump.external_transition(TIME("00:00:03:000"), move(pump_in));
+        }
+        do_not_optimize(reservoir.state.volume);
+    }
+    state.items = state.iterations * n;
+}
+
+/****** Next event time of a pumping city pump and the engine's scheduling of it (last + time_advance, compared with the next input) *******************/
+template<typename T>
+void city_pump_schedule(benchmark_state& state, bool parse) {
+    CityPump<T> pump;
+    pump.state.active = true;
+    T last, next_input("24:00:00:000");
+    for (long long i = 0; i < state.iterations; i++) {
+        // parse: the packet period built from its text form at every call, as time_advance() did before model_durations
+        T next = last + (parse ? T("00:00:30:000") : pump.time_advance());
+        last = next < next_input ? next : T();
+        do_not_optimize(last);
+    }
+    state.items = state.iterations;
+}
+
+/****** End to end TOP model, no logging, with the build's time type or the given one *******************/
+template<typename T = TIME>
+void top_model(benchmark_state& state, const char * pumps_input, const char * supply_input, int days) {
+    T until = T("00:00:00:000");
+    for (int d = 0; d < days; d++) until = until + T("24:00:00:000");
+    for (long long i = 0; i < state.iterations; i++) {
+        event_counter::reset();
+        shared_ptr<dynamic::modeling::coupled<T>> TOP = make_city_supply<T>(pumps_input, supply_input);
+        dynamic::engine::runner<T, event_counter> r(TOP, {0});
+        r.run_until(until);
+        state.items += event_counter::steps;
+    }
+}
+
+int main(int argc, char ** argv) {
+    // Only the benchmarks whose name contains the filter are run
+    string filter = argc > 1 ? argv[1] : "";
+    const char * pumps_input  = argc > 2 ? argv[2] : "../input_data/city_pump_instr.txt";
+    const char * supply_input = argc > 3 ? argv[3] : "../input_data/water_supply_instr.txt";
+    auto bench = [&](const string& name, const function<void(benchmark_state&)>& body, double min_seconds = 0.5) {
+        if (name.find(filter) != string::npos) run_benchmark(name, body, min_seconds);
+    };
+
+    print_benchmark_header();
+    for (int n : {1, 8, 64, 512, 4096}) {
+        bench("Reservoir::external_transition/" + to_string(n), [n](benchmark_state& s) { reservoir_external(s, n); });
+    }
+    for (int n : {64, 1024}) {
+        bench("Reservoir<float>::external_transition/" + to_string(n), [n](benchmark_state& s) { reservoir_external<float>(s, n); });
+        bench("Reservoir<double>::external_transition/" + to_string(n), [n](benchmark_state& s) { reservoir_external<double>(s, n); });
+        bench("Reservoir<fixed_volume>::external_transition/" + to_string(n), [n](benchmark_state& s) { reservoir_external<fixed_volume>(s, n); });
+    }
+    for (int n : {8, 32, 128, 512, 1024}) {
+        bench("flow bag sum float adds/" + to_string(n), [n](benchmark_state& s) { flow_bag_sum(s, n, false); });
+        bench("flow bag sum flow_sum/" + to_string(n), [n](benchmark_state& s) { flow_bag_sum(s, n, true); });
+    }
+    bench("WaterSupplyPump::external_transition", supply_pump_external);
+    bench("CityPump::output", city_pump_output);
+    for (int n : {2, 16, 128}) {
+        bench("make_message_bags round trip/" + to_string(n), [n](benchmark_state& s) { message_bags_round_trip(s, n); });
+    }
+    bench("CityPump schedule NDTime parsed", [](benchmark_state& s) { city_pump_schedule<NDTime>(s, true); });
+    bench("CityPump schedule NDTime", [](benchmark_state& s) { city_pump_schedule<NDTime>(s, false); });
+    bench("CityPump schedule tick_time", [](benchmark_state& s) { city_pump_schedule<tick_time>(s, false); });
+    for (int days : {1, 7, 30}) {
+        bench("TOP/" + to_string(days) + "d", [&, days](benchmark_state& s) { top_model(s, pumps_input, supply_input, days); }, 2.0);
+    }
+    for (int days : {1, 7}) {
+        bench("TOP<NDTime>/" + to_string(days) + "d", [&, days](benchmark_state& s) { top_model<NDTime>(s, pumps_input, supply_input, days); }, 2.0);
+        bench("TOP<tick_time>/" + to_string(days) + "d", [&, days](benchmark_state& s) { top_model<tick_time>(s, pumps_input, supply_input, days); }, 2.0);
+    }
+    if (string("volume drift").find(filter) != string::npos) {
+        for (int days : {30, 365}) print_volume_drift(days);
+    }
+    if (string("mass balance").find(filter) != string::npos) {
+        print_mass_balance<float>("float", 365);
+        print_mass_balance<double>("double", 365);
+        print_mass_balance<fixed_volume>("fixed_volume", 365);
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model headers
+#include "../top_model/city_supply.hpp"
+#include "../top_model/city_supply_static.hpp"
+#include "event_counter.hpp"
+
+//C++ headers
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+using TIME = time_type;
+using hclock = chrono::high_resolution_clock;
+
+struct bench_result {
+    long long events;
+    double seconds;
+};
+
+bench_result run_dynamic(const char * pumps_input, const char * supply_input, const TIME& until) {
+    event_counter::reset();
+    auto start = hclock::now();
+    shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_city_supply<TIME>(pumps_input, supply_input);
+    dynamic::engine::runner<TIME, event_counter> r(TOP, {0});
+    r.run_until(until);
+    double elapsed = chrono::duration<double>(hclock::now() - start).count();
+    return {event_counter::steps, elapsed};
+}
+
+city_supply_static_parameters static_parameters;
+
+bench_result run_static(const char * pumps_input, const char * supply_input, const TIME& until) {
+    event_counter::reset();
+    static_parameters.pumps_input = pumps_input;
+    static_parameters.supply_input = supply_input;
+    auto start = hclock::now();
+    engine::runner<TIME, city_supply_static<static_parameters>::TOP, event_counter> r(TIME("00:00:00:000"));
+    r.run_until(until);
+    double elapsed = chrono::duration<double>(hclock::now() - start).count();
+    return {event_counter::steps, elapsed};
+}
+
+void report(const string& name, const bench_result& res) {
+    cout << name << ": " << res.events << " events in " << res.seconds << " s ("
+         << (res.seconds > 0 ? res.events / res.seconds : 0) << " events/s)" << endl;
+}
+
+int main(int argc, char ** argv) {
+    const char * pumps_input  = argc > 1 ? argv[1] : "../input_data/city_pump_instr.txt";
+    const char * supply_input = argc > 2 ? argv[2] : "../input_data/water_supply_instr.txt";
+    int repetitions = argc > 3 ? atoi(argv[3]) : 20;
+    TIME until("24:00:00:000");
+
+    bench_result dynamic_total = {0, 0};
+    bench_result static_total = {0, 0};
+    for (int i = 0; i < repetitions; i++) {
+        bench_result d = run_dynamic(pumps_input, supply_input, until);
+        bench_result s = run_static(pumps_input, supply_input, until);
+        dynamic_total.events += d.events;
+        dynamic_total.seconds += d.seconds;
+        static_total.events += s.events;
+        static_total.seconds += s.seconds;
+    }
+    cout << repetitions << " runs of 24h, logging disabled" << endl;
+    report("dynamic runner", dynamic_total);
+    report("static runner ", static_total);
+    // Timings only compare if both runners went through the same steps
+    if (static_total.events != dynamic_total.events) {
+        cout << "the runners made a different number of steps, no speedup reported" << endl;
+    } else if (static_total.seconds > 0) {
+        cout << "speedup: " << dynamic_total.seconds / static_total.seconds << "x" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model headers
+#include "../top_model/network.hpp"
+#include "event_counter.hpp"
+
+//C++ headers
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+using TIME = time_type;
+using hclock = chrono::high_resolution_clock;
+
+// Scaling of the generated network: 5 supply and 5 city pumps per reservoir, each size built with the coupled models and flat
+int main(int argc, char ** argv) {
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(atoi(argv[i]));
+    if (sizes.empty()) sizes = {10, 100, 1000};
+    const int pumps_per_reservoir = 5;
+    TIME until("24:00:00:000");
+
+    cout << "layout,pumps,reservoirs,build_ms,run_s,steps,events,events_per_s" << endl;
+    for (int pumps : sizes) for (bool flat : {false, true}) {
+        int reservoirs = max(1, pumps / (2 * pumps_per_reservoir));
+        event_counter::reset();
+
+        auto start = hclock::now();
+        network_description network = make_network(reservoirs, pumps_per_reservoir, "../input_data/city_pump_instr.txt", "../input_data/water_supply_instr.txt");
+        shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_network_model<TIME>(network, 1, 0.1, TIME("00:30:00:000"), model_parameters(), flat);
+        dynamic::engine::runner<TIME, event_counter> r(TOP, {0});
+        auto built = hclock::now();
+        r.run_until(until);
+        auto done = hclock::now();
+
+        double build_ms = chrono::duration<double, milli>(built - start).count();
+        double run_s = chrono::duration<double>(done - built).count();
+        cout << (flat ? "flat" : "hierarchical") << "," << reservoirs * 2 * pumps_per_reservoir << "," << reservoirs << "," << build_ms << "," << run_s << ","
+             << event_counter::steps << "," << event_counter::outputs << "," << (run_s > 0 ? event_counter::outputs / run_s : 0) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model headers
+#include "../top_model/network_partitions.hpp"
+
+//C++ headers
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+using TIME = time_type;
+using hclock = chrono::high_resolution_clock;
+
+// Scaling of the partitioned run of a generated network (5 supply and 5 city pumps per reservoir) on 1 to 32 threads
+int main(int argc, char ** argv) {
+    int pumps = argc > 1 ? atoi(argv[1]) : 640;
+    unsigned int max_threads = argc > 2 ? atoi(argv[2]) : 32;
+    const int pumps_per_reservoir = 5;
+    int reservoirs = max(1, pumps / (2 * pumps_per_reservoir));
+    TIME until("24:00:00:000");
+    network_description network = make_network(reservoirs, pumps_per_reservoir, "../input_data/city_pump_instr.txt", "../input_data/water_supply_instr.txt");
+
+    // The supply and city volumes must not depend on the number of threads
+    cout << "pumps,reservoirs,threads,partitions,run_s,speedup,supply_volume,city_volume" << endl;
+    double sequential_s = 0;
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        vector<network_description> partitions = partition_network(network, threads);
+        auto start = hclock::now();
+        run_statistics<TIME>::data = run_partitions<TIME>(partitions, threads, until, false);
+        double run_s = chrono::duration<double>(hclock::now() - start).count();
+        if (threads == 1) sequential_s = run_s;
+
+        cout << reservoirs * 2 * pumps_per_reservoir << "," << reservoirs << "," << threads << "," << partitions.size() << "," << run_s << ","
+             << (run_s > 0 ? sequential_s / run_s : 0) << "," << run_statistics<TIME>::volume(true) << "," << run_statistics<TIME>::volume(false) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model headers
+#include "../top_model/network.hpp"
+#include "../top_model/network_simulator.hpp"
+#include "event_counter.hpp"
+
+//C++ headers
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+using TIME = time_type;
+using hclock = chrono::high_resolution_clock;
+
+struct scheduler_result {
+    double build_ms;
+    double run_s;
+};
+
+template<typename RUN>
+scheduler_result measure(RUN run) {
+    event_counter::reset();
+    auto start = hclock::now();
+    auto built = run();
+    auto done = hclock::now();
+    return {chrono::duration<double, milli>(built - start).count(), chrono::duration<double>(done - built).count()};
+}
+
+// Copy of <network> where station r reads its inputs shifted by (r % inputs) * 437 ms, written next to the results, so the stations are imminent at different times
+network_description stagger(network_description network, int inputs) {
+    const int64_t commands_ms[] = {60000, 3600000, 5400000}; // Times of the commands of city_pump_instr.txt and water_supply_instr.txt
+    const int values[] = {1, 0, 1};
+    network.inputs.clear();
+    for (int k = 0; k < inputs; k++) {
+        string path = "../simulation_results/scheduler_bench_input_" + to_string(k) + ".txt";
+        ofstream file(path);
+        for (int c = 0; c < 3; c++) {
+            int64_t ms = commands_ms[c] + k * 437;
+            char line[64];
+            snprintf(line, sizeof(line), "%02d:%02d:%02d:%03d %d", int(ms / 3600000), int(ms / 60000 % 60), int(ms / 1000 % 60), int(ms % 1000), values[c]);
+            file << line << endl;
+        }
+        network.inputs.push_back({"input" + to_string(k), path, nullptr});
+    }
+    for (size_t r = 0; r < network.reservoirs.size(); r++) {
+        network.reservoirs[r].pumps_input = network.reservoirs[r].supply_input = "input" + to_string(r % inputs);
+    }
+    return network;
+}
+
+// Next event selection on generated networks (5 supply and 5 city pumps per reservoir): the runner, network_simulator scanning every model, and its heap.
+// With shared inputs every station steps at the same times, with staggered inputs up to 64 groups of stations step at different times.
+int main(int argc, char ** argv) {
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(atoi(argv[i]));
+    if (sizes.empty()) sizes = {10, 100, 1000, 10000};
+    const int pumps_per_reservoir = 5;
+    const int runner_max_pumps = 1000; // The runner takes minutes per simulated day above
+    TIME until("24:00:00:000");
+
+    cout << "scheduler,inputs,pumps,reservoirs,build_ms,run_s,steps,events,events_per_s" << endl;
+    for (int pumps : sizes) {
+        int reservoirs = max(1, pumps / (2 * pumps_per_reservoir));
+        network_description shared = make_network(reservoirs, pumps_per_reservoir, "../input_data/city_pump_instr.txt", "../input_data/water_supply_instr.txt");
+        for (bool staggered : {false, true}) for (const char * name : {"runner", "linear", "heap"}) {
+            string scheduler_name = name;
+            if (scheduler_name == "runner" && pumps > runner_max_pumps) continue;
+            network_description network = staggered ? stagger(shared, min(reservoirs, 64)) : shared;
+            scheduler_result result = measure([&]() {
+                if (scheduler_name == "runner") {
+                    dynamic::engine::runner<TIME, event_counter> r(make_network_model<TIME>(network), {0});
+                    auto built = hclock::now();
+                    r.run_until(until);
+                    return built;
+                }
+                network_simulator<TIME, event_counter> simulator(network, 1, 0.1, TIME("00:30:00:000"), model_parameters(),
+                                                                 scheduler_name == "heap" ? scheduler::heap : scheduler::linear);
+                auto built = hclock::now();
+                simulator.run_until(until);
+                return built;
+            });
+            cout << scheduler_name << "," << (staggered ? "staggered" : "shared") << "," << reservoirs * 2 * pumps_per_reservoir << "," << reservoirs << "," << result.build_ms << "," << result.run_s << ","
+                 << event_counter::steps << "," << event_counter::outputs << "," << (result.run_s > 0 ? event_counter::outputs / result.run_s : 0) << endl;
+        }
+    }
+    return 0;
+}
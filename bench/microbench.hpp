@@ -0,0 +1,55 @@
+/**
+ * Minimal microbenchmark harness in the style of Google Benchmark, so the
+ * benchmarks build with the same toolchain as the simulator and no extra
+ * dependency. A benchmark is a function running its body state.iterations
+ * times; the iteration count grows until the run takes min_seconds and the
+ * time per iteration is printed in a table.
+**/
+
+#ifndef _MICROBENCH_HPP__
+#define _MICROBENCH_HPP__
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+struct benchmark_state {
+    long long iterations;
+    long long items = 0; // Items processed in total (messages, events), reported per second when set
+};
+
+// Keeps the compiler from optimizing away a value the benchmark computes
+template<typename T> inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void print_benchmark_header() {
+    cout << left << setw(48) << "benchmark" << right << setw(14) << "ns/iter" << setw(14) << "iterations" << setw(16) << "items/s" << endl;
+}
+
+inline void run_benchmark(const string& name, const function<void(benchmark_state&)>& body, double min_seconds = 0.5) {
+    using hclock = chrono::steady_clock;
+    benchmark_state state = {1};
+    double seconds = 0;
+    for (;;) {
+        state.items = 0;
+        auto start = hclock::now();
+        body(state);
+        seconds = chrono::duration<double>(hclock::now() - start).count();
+        if (seconds >= min_seconds || state.iterations >= (1LL << 40)) break;
+        // Aim a bit past min_seconds, growing at most 10x per round like Google Benchmark
+        double factor = seconds > 0 ? min_seconds * 1.4 / seconds : 10;
+        state.iterations = (long long)(state.iterations * (factor < 10 ? (factor > 1.1 ? factor : 1.1) : 10)) + 1;
+    }
+    cout << left << setw(48) << name << right << fixed << setprecision(1) << setw(14) << seconds * 1e9 / state.iterations
+         << setw(14) << state.iterations << setw(16) << setprecision(0);
+    if (state.items > 0) cout << state.items / seconds;
+    else cout << "-";
+    cout << endl;
+    cout.unsetf(ios::floatfield);
+}
+#endif // _MICROBENCH_HPP__
@@ -0,0 +1,131 @@
+/**
+ * Stream buffer handing log output to a background writer thread
+ *
+ * Output is formatted into one of a fixed number of slots; a full slot is
+ * published through a single producer / single consumer lock-free ring and
+ * written to the file by the writer thread while the simulation fills the
+ * next one. Memory is bounded by slots * slot_size: when every slot is waiting
+ * to be written the simulation waits for the writer (backpressure). Flushes
+ * (std::endl) are absorbed, data reaches the file when a slot is full, on a
+ * seek, and on close(), which must be called once the run is over.
+**/
+
+#ifndef _ASYNC_FILEBUF_HPP__
+#define _ASYNC_FILEBUF_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ios>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class async_filebuf : public streambuf {
+public:
+    explicit async_filebuf(size_t slot_count = 8, size_t slot_size = 1 << 16)
+        : slots(slot_count, vector<char>(slot_size)), sizes(slot_count, 0) {}
+    ~async_filebuf() { close(); }
+
+    bool open(const char * path, ios::openmode mode = ios::out) {
+        close();
+        file = fopen(path, (mode & ios::app) ? "ab" : "wb");
+        if (!file) return false;
+        head = 0;
+        tail = 0;
+        stop = false;
+        setp(slots[0].data(), slots[0].data() + slots[0].size());
+        worker = thread(&async_filebuf::write_slots, this);
+        return true;
+    }
+    bool is_open() const { return file != nullptr; }
+
+    // Publishes what is left, waits for the writer and closes the file
+    void close() {
+        if (!file) return;
+        publish();
+        stop.store(true, memory_order_release);
+        worker.join();
+        fclose(file);
+        file = nullptr;
+        setp(nullptr, nullptr);
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!file) return traits_type::eof();
+        publish();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    int sync() override {
+        return file ? 0 : -1;
+    }
+    // Seeking (e.g. to rewrite a header) waits until everything before it is written
+    pos_type seekoff(off_type off, ios::seekdir dir, ios::openmode which) override {
+        if (!file || !(which & ios::out)) return pos_type(off_type(-1));
+        publish();
+        drain();
+        fflush(file);
+        int whence = dir == ios::beg ? SEEK_SET : (dir == ios::cur ? SEEK_CUR : SEEK_END);
+        if ((off != 0 || dir != ios::cur) && fseeko(file, off, whence) != 0) return pos_type(off_type(-1));
+        return pos_type(ftello(file));
+    }
+    pos_type seekpos(pos_type pos, ios::openmode which) override {
+        return seekoff(off_type(pos), ios::beg, which);
+    }
+
+private:
+    vector<vector<char>> slots;
+    vector<size_t> sizes;
+    atomic<size_t> head{0}; // Next slot to publish, only written by the simulation thread
+    atomic<size_t> tail{0}; // Next slot to write, only written by the writer thread
+    atomic<bool> stop{false};
+    FILE * file = nullptr;
+    thread worker;
+
+    // Hands the current slot to the writer and moves to the next free one
+    void publish() {
+        size_t size = pptr() - pbase();
+        if (size == 0) return;
+        size_t h = head.load(memory_order_relaxed);
+        sizes[h % slots.size()] = size;
+        head.store(h + 1, memory_order_release);
+        while (h + 1 - tail.load(memory_order_acquire) >= slots.size()) this_thread::yield();
+        vector<char>& next = slots[(h + 1) % slots.size()];
+        setp(next.data(), next.data() + next.size());
+    }
+    void drain() {
+        while (tail.load(memory_order_acquire) != head.load(memory_order_relaxed)) this_thread::yield();
+    }
+    void write_slots() {
+        while (true) {
+            // stop is read before head so the slots published by close() are always seen
+            bool stopping = stop.load(memory_order_acquire);
+            size_t t = tail.load(memory_order_relaxed);
+            if (t != head.load(memory_order_acquire)) {
+                fwrite(slots[t % slots.size()].data(), 1, sizes[t % slots.size()], file);
+                tail.store(t + 1, memory_order_release);
+            } else if (stopping) {
+                break;
+            } else {
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+        }
+        fflush(file);
+    }
+};
+
+// Redirects os to path through buffer, e.g. a sink ofstream of the loggers
+inline bool open_async(ostream& os, async_filebuf& buffer, const char * path, ios::openmode mode = ios::out) {
+    if (!buffer.open(path, mode)) return false;
+    os.rdbuf(&buffer);
+    return true;
+}
+#endif // _ASYNC_FILEBUF_HPP__
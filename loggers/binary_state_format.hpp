@@ -0,0 +1,134 @@
+/**
+ * Binary state log format of the City Water Supply model
+ *
+ * Header, fixed width records, footer with the model ids and the text states.
+ * Records keep the log order: a time record per simulation step followed by
+ * one record per model state, so the text state log can be rebuilt exactly.
+ *
+ * Every field is written little endian whatever the machine, floats as their
+ * IEEE 754 bits, with write_header()/write_record() and read back with
+ * read_header()/read_record(), so a log reads the same on any machine.
+**/
+
+#ifndef _BINARY_STATE_FORMAT_HPP__
+#define _BINARY_STATE_FORMAT_HPP__
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace binary_state {
+
+    const char     magic[8] = {'C', 'W', 'S', 'S', 'T', 'A', 'T', 'E'};
+    const uint32_t version  = 2;
+
+    // magic, uint32 version, uint32 record size, uint64 record count, uint64 footer offset
+    const size_t header_size = 32;
+    // int64 time, uint32 model, uint8 kind, uint8 flags, uint16 reserved, then two floats or uint32 text + uint32 0
+    const size_t record_size = 24;
+
+    // Time of the records, in milliseconds, infinity is the largest int64
+    const int64_t infinite_time = std::numeric_limits<int64_t>::max();
+
+    struct header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t record_count;
+        uint64_t footer_offset; // Footer: model ids then text states, each as uint32 count + (uint32 length, chars)
+    };
+
+    enum kind : uint8_t {
+        time_step        = 0,
+        reservoir        = 1,
+        water_supply_pump = 2,
+        city_pump        = 3,
+        text             = 4  // States of other models, kept in the footer
+    };
+
+    enum flag : uint8_t {
+        active   = 1, // Reservoir: reading
+        blockage = 2,
+        wait     = 4
+    };
+
+    struct record {
+        int64_t  time;  // Milliseconds
+        uint32_t model; // Index in the model ids
+        uint8_t  kind;
+        uint8_t  flags;
+        float    value[2]; // Reservoir: volume and level
+        uint32_t text;     // Index in the text states
+    };
+
+    /****** Little endian fields *******************/
+    template<typename T> void put(char * out, T value) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Fields are 4 or 8 bytes, the others are written byte by byte");
+        typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type v;
+        memcpy(&v, &value, sizeof(T));
+        for (size_t i = 0; i < sizeof(T); i++) out[i] = char(v >> (8 * i));
+    }
+    template<typename T> T get(const char * in) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Fields are 4 or 8 bytes, the others are read byte by byte");
+        typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type v = 0;
+        for (size_t i = 0; i < sizeof(T); i++) v |= decltype(v)((unsigned char) in[i]) << (8 * i);
+        T value;
+        memcpy(&value, &v, sizeof(T));
+        return value;
+    }
+
+    inline void write_header(char * out, const header& h) {
+        memcpy(out, h.magic, sizeof(h.magic));
+        put<uint32_t>(out + 8, h.version);
+        put<uint32_t>(out + 12, h.record_size);
+        put<uint64_t>(out + 16, h.record_count);
+        put<uint64_t>(out + 24, h.footer_offset);
+    }
+    inline header read_header(const char * in) {
+        header h;
+        memcpy(h.magic, in, sizeof(h.magic));
+        h.version = get<uint32_t>(in + 8);
+        h.record_size = get<uint32_t>(in + 12);
+        h.record_count = get<uint64_t>(in + 16);
+        h.footer_offset = get<uint64_t>(in + 24);
+        return h;
+    }
+
+    inline void write_record(char * out, const record& r) {
+        put<int64_t>(out, r.time);
+        put<uint32_t>(out + 8, r.model);
+        out[12] = char(r.kind);
+        out[13] = char(r.flags);
+        out[14] = out[15] = 0;
+        if (r.kind == text) {
+            put<uint32_t>(out + 16, r.text);
+            put<uint32_t>(out + 20, 0);
+        } else {
+            put<float>(out + 16, r.value[0]);
+            put<float>(out + 20, r.value[1]);
+        }
+    }
+    inline record read_record(const char * in) {
+        record r = {get<int64_t>(in), get<uint32_t>(in + 8), uint8_t(in[12]), uint8_t(in[13]), {0, 0}, 0};
+        if (r.kind == text) {
+            r.text = get<uint32_t>(in + 16);
+        } else {
+            r.value[0] = get<float>(in + 16);
+            r.value[1] = get<float>(in + 20);
+        }
+        return r;
+    }
+
+    // Same layout as NDTime prints, hh:mm:ss:mmm
+    inline std::string time_to_string(int64_t time) {
+        if (time == infinite_time) return "inf";
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%02lld:%02lld:%02lld:%03lld", (long long) (time / 3600000),
+                 (long long) (time / 60000 % 60), (long long) (time / 1000 % 60), (long long) (time % 1000));
+        return buffer;
+    }
+}
+#endif // _BINARY_STATE_FORMAT_HPP__
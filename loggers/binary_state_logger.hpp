@@ -0,0 +1,234 @@
+/**
+ * Cadmium logger writing the state log in the binary format of binary_state_format.hpp
+ *
+ * Handles logger_global_time and logger_state. Times are stored as their
+ * integer milliseconds (time_to_ms()). States of the static runner arrive
+ * typed and are stored without formatting. The dynamic runner only hands over
+ * the text of a state: the atomic models of the TOP model given to watch()
+ * are read directly instead, the text of other models is parsed back into
+ * the same fields. Models this logger does not know (e.g. the input readers)
+ * are kept as deduplicated text. finish() must be called once the run is
+ * over to write the footer.
+**/
+
+#ifndef _BINARY_STATE_LOGGER_HPP__
+#define _BINARY_STATE_LOGGER_HPP__
+
+#include <cadmium/logger/common_loggers.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+
+#include "binary_state_format.hpp"
+#include "../atomics/reservoir.hpp"
+#include "../atomics/water_supply_pump.hpp"
+#include "../atomics/city_pump.hpp"
+#include "../atomics/continuous_reservoir.hpp"
+#include "../atomics/continuous_water_supply_pump.hpp"
+#include "../atomics/continuous_city_pump.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+template<typename TIME, typename SINK_PROVIDER> struct binary_state_logger {
+    static const size_t buffer_records = 4096;
+
+    static inline bool     started = false;
+    static inline int64_t  now = 0;
+    static inline uint64_t record_count = 0;
+    static inline vector<char> buffer; // Records written little endian, see binary_state_format.hpp
+    static inline unordered_map<string, function<void(binary_state::record&)>> watched;
+    static inline unordered_map<string, uint32_t> model_index;
+    static inline vector<string> models;
+    static inline unordered_map<string, uint32_t> text_index;
+    static inline vector<string> texts;
+
+    template<typename DECLARED_SOURCE, typename... FORMATS, typename... PARAMs>
+    static void log(const PARAMs&... ps) {
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_global_time>::value) record_time(ps...);
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_state>::value) record_state(ps...);
+    }
+
+    static void record_time(const TIME& t) {
+        now = time_to_ms(t);
+        binary_state::record r = new_record(binary_state::time_step, 0);
+        push(r);
+    }
+
+    // Fields of the states this logger knows, the same values their operator<< prints
+    static void fill(binary_state::record& r, const typename Reservoir<TIME>::state_type& s) {
+        r.kind = binary_state::reservoir;
+        r.flags = s.reading ? binary_state::active : 0;
+        r.value[0] = (float) (double) s.volume;
+        r.value[1] = volume_level(s.volume, s.surface);
+    }
+    static void fill(binary_state::record& r, const typename ContinuousReservoir<TIME>::state_type& s) {
+        r.kind = binary_state::reservoir;
+        r.value[0] = (float) s.volume;
+        r.value[1] = (float) (s.volume / s.surface);
+    }
+    template<typename STATE>
+    static void fill_supply_pump(binary_state::record& r, const STATE& s) {
+        r.kind = binary_state::water_supply_pump;
+        r.flags = (s.active ? binary_state::active : 0) | (s.blockage ? binary_state::blockage : 0) | (s.wait ? binary_state::wait : 0);
+    }
+    static void fill(binary_state::record& r, const typename WaterSupplyPump<TIME>::state_type& s) { fill_supply_pump(r, s); }
+    static void fill(binary_state::record& r, const typename ContinuousWaterSupplyPump<TIME>::state_type& s) { fill_supply_pump(r, s); }
+    template<typename STATE>
+    static void fill_city_pump(binary_state::record& r, const STATE& s) {
+        r.kind = binary_state::city_pump;
+        r.flags = (s.active ? binary_state::active : 0) | (s.wait ? binary_state::wait : 0);
+    }
+    static void fill(binary_state::record& r, const typename CityPump<TIME>::state_type& s) { fill_city_pump(r, s); }
+    static void fill(binary_state::record& r, const typename ContinuousCityPump<TIME>::state_type& s) { fill_city_pump(r, s); }
+
+    // Atomic models of a dynamic TOP model whose state is read when the runner logs it, instead of parsing its text
+    static void watch(const shared_ptr<dynamic::modeling::coupled<TIME>>& coupled) {
+        for (const shared_ptr<dynamic::modeling::model>& m : coupled->_models) {
+            if (auto c = dynamic_pointer_cast<dynamic::modeling::coupled<TIME>>(m)) {
+                watch(c);
+            } else {
+                watch_atomic<Reservoir<TIME>, ContinuousReservoir<TIME>, WaterSupplyPump<TIME>, ContinuousWaterSupplyPump<TIME>,
+                             CityPump<TIME>, ContinuousCityPump<TIME>>(*m);
+            }
+        }
+    }
+
+    // States of the static runner
+    static void record_state(const TIME& t, const string& model_id, const typename Reservoir<TIME>::state_type& s) { record_fields(model_id, s); }
+    static void record_state(const TIME& t, const string& model_id, const typename WaterSupplyPump<TIME>::state_type& s) { record_fields(model_id, s); }
+    static void record_state(const TIME& t, const string& model_id, const typename CityPump<TIME>::state_type& s) { record_fields(model_id, s); }
+    template<typename STATE>
+    static void record_state(const TIME& t, const string& model_id, const STATE& s) {
+        ostringstream oss;
+        oss << s;
+        record_state(t, model_id, oss.str());
+    }
+
+    // States of the dynamic runner, formatted by the operator<< of each atomic
+    static void record_state(const TIME& t, const string& model_id, const string& s) {
+        binary_state::record r = new_record(binary_state::text, index_of(model_id));
+        auto it = watched.find(model_id);
+        if (it != watched.end()) {
+            it->second(r);
+            push(r);
+            return;
+        }
+        const char * c = s.c_str();
+        if (strncmp(c, "volume: ", 8) == 0 && strstr(c, " & level: ")) {
+            r.kind = binary_state::reservoir;
+            r.value[0] = strtof(c + 8, nullptr);
+            r.value[1] = strtof(strstr(c, " & level: ") + 10, nullptr);
+        } else if (strncmp(c, "active: ", 8) == 0 && s.size() == 9) {
+            r.kind = binary_state::city_pump;
+            r.flags = c[8] == '1' ? binary_state::active : 0;
+        } else if (strncmp(c, "active: ", 8) == 0 && s.size() == 36 && s.compare(9, 13, " & blockage: ") == 0 && s.compare(23, 12, " & waiting: ") == 0) {
+            r.kind = binary_state::water_supply_pump;
+            r.flags = (c[8] == '1' ? binary_state::active : 0) | (c[22] == '1' ? binary_state::blockage : 0) | (c[35] == '1' ? binary_state::wait : 0);
+        } else {
+            r.text = text_of(s);
+        }
+        push(r);
+    }
+
+    // Writes the last records, the footer and the final header
+    static void finish() {
+        ostream& os = SINK_PROVIDER::sink();
+        if (!started) write_header(os);
+        flush(os);
+        binary_state::header h = make_header();
+        h.footer_offset = binary_state::header_size + record_count * binary_state::record_size;
+        write_strings(os, models);
+        write_strings(os, texts);
+        os.seekp(0);
+        char bytes[binary_state::header_size];
+        binary_state::write_header(bytes, h);
+        os.write(bytes, sizeof(bytes));
+        os.flush();
+        started = false;
+        record_count = 0;
+        watched.clear();
+        model_index.clear();
+        models.clear();
+        text_index.clear();
+        texts.clear();
+    }
+
+private:
+    template<typename ATOMIC, typename... OTHERS>
+    static void watch_atomic(const dynamic::modeling::model& m) {
+        if (const ATOMIC * a = dynamic_cast<const ATOMIC *>(&m)) {
+            watched[m.get_id()] = [a](binary_state::record& r) { fill(r, a->state); };
+        } else if constexpr (sizeof...(OTHERS) > 0) {
+            watch_atomic<OTHERS...>(m);
+        }
+    }
+    template<typename STATE>
+    static void record_fields(const string& model_id, const STATE& s) {
+        binary_state::record r = new_record(binary_state::text, index_of(model_id));
+        fill(r, s);
+        push(r);
+    }
+    static binary_state::record new_record(uint8_t kind, uint32_t model) {
+        return {now, model, kind, 0, {0, 0}, 0};
+    }
+    static void push(const binary_state::record& r) {
+        if (!started) write_header(SINK_PROVIDER::sink());
+        size_t end = buffer.size();
+        buffer.resize(end + binary_state::record_size);
+        binary_state::write_record(&buffer[end], r);
+        if (buffer.size() >= buffer_records * binary_state::record_size) flush(SINK_PROVIDER::sink());
+    }
+    static uint32_t index_of(const string& model_id) {
+        auto it = model_index.find(model_id);
+        if (it != model_index.end()) return it->second;
+        models.push_back(model_id);
+        return model_index[model_id] = models.size() - 1;
+    }
+    static uint32_t text_of(const string& s) {
+        auto it = text_index.find(s);
+        if (it != text_index.end()) return it->second;
+        texts.push_back(s);
+        return text_index[s] = texts.size() - 1;
+    }
+    static binary_state::header make_header() {
+        binary_state::header h;
+        memcpy(h.magic, binary_state::magic, sizeof(h.magic));
+        h.version = binary_state::version;
+        h.record_size = binary_state::record_size;
+        h.record_count = record_count;
+        h.footer_offset = 0;
+        return h;
+    }
+    static void write_header(ostream& os) {
+        char bytes[binary_state::header_size];
+        binary_state::write_header(bytes, make_header());
+        os.write(bytes, sizeof(bytes));
+        started = true;
+    }
+    static void flush(ostream& os) {
+        os.write(buffer.data(), buffer.size());
+        record_count += buffer.size() / binary_state::record_size;
+        buffer.clear();
+    }
+    static void write_strings(ostream& os, const vector<string>& strings) {
+        char field[4];
+        binary_state::put<uint32_t>(field, strings.size());
+        os.write(field, sizeof(field));
+        for (const string& s : strings) {
+            binary_state::put<uint32_t>(field, s.size());
+            os.write(field, sizeof(field));
+            os.write(s.data(), s.size());
+        }
+    }
+};
+#endif // _BINARY_STATE_LOGGER_HPP__
@@ -0,0 +1,112 @@
+/**
+ * Cadmium logger writing only the states that changed
+ *
+ * Handles logger_global_time and logger_state. The first state of every model
+ * is always written, afterwards a model is written only when the text of its
+ * state differs from the last one written, and a time line only precedes steps with at least
+ * one change. The full state of every model at any time is therefore the last
+ * line written for it at or before that time. Lines have the same layout as
+ * the text state log.
+**/
+
+#ifndef _DELTA_STATE_LOGGER_HPP__
+#define _DELTA_STATE_LOGGER_HPP__
+
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+template<typename TIME, typename SINK_PROVIDER> struct delta_state_logger {
+    static inline TIME now;
+    static inline bool time_written = true;
+
+    template<typename DECLARED_SOURCE, typename... FORMATS, typename... PARAMs>
+    static void log(const PARAMs&... ps) {
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_global_time>::value) record_time(ps...);
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_state>::value) record_state(ps...);
+    }
+
+    static void record_time(const TIME& t) {
+        now = t;
+        time_written = false;
+    }
+
+    // A model is written when the text of its state changed. Typed states (static runner) are first compared
+    // with their operator==, which covers every printed field, so unchanged states are not formatted
+    template<typename STATE>
+    static void record_state(const TIME& t, const string& model_id, const STATE& s) {
+        if constexpr (!is_same<STATE, string>::value && is_equality_comparable<STATE>::value) {
+            unordered_map<string, STATE>& states = last_states<STATE>();
+            auto it = states.find(model_id);
+            if (it == states.end()) {
+                states.emplace(model_id, s);
+            } else {
+                if (it->second == s) return;
+                it->second = s;
+            }
+        }
+        ostringstream oss;
+        oss << s;
+        string text = oss.str();
+        if (changed(model_id, text)) write(model_id, text);
+    }
+
+    // Forgets the last states, to be called between runs
+    static void reset() {
+        time_written = true;
+        for (auto clear : clear_tables) clear();
+    }
+
+private:
+    template<typename STATE, typename = void>
+    struct is_equality_comparable : false_type {};
+    template<typename STATE>
+    struct is_equality_comparable<STATE, void_t<decltype(declval<const STATE&>() == declval<const STATE&>())>> : true_type {};
+
+    // One table of last typed states per state type, and the last text written for every model
+    static inline vector<void (*)()> clear_tables;
+    template<typename STATE>
+    static unordered_map<string, STATE>& last_states() {
+        static unordered_map<string, STATE> states;
+        static bool registered = (clear_tables.push_back([]() { last_states<STATE>().clear(); }), true);
+        (void) registered;
+        return states;
+    }
+    static unordered_map<string, string>& last_texts() {
+        static unordered_map<string, string> texts;
+        static bool registered = (clear_tables.push_back([]() { last_texts().clear(); }), true);
+        (void) registered;
+        return texts;
+    }
+
+    static bool changed(const string& model_id, const string& text) {
+        unordered_map<string, string>& texts = last_texts();
+        auto it = texts.find(model_id);
+        if (it == texts.end()) {
+            texts.emplace(model_id, text);
+            return true;
+        }
+        if (it->second == text) return false;
+        it->second = text;
+        return true;
+    }
+
+    static void write(const string& model_id, const string& text) {
+        ostream& os = SINK_PROVIDER::sink();
+        if (!time_written) {
+            os << now << '\n';
+            time_written = true;
+        }
+        os << "State for model " << model_id << " is " << text << '\n';
+    }
+};
+#endif // _DELTA_STATE_LOGGER_HPP__
@@ -0,0 +1,194 @@
+/**
+ * Cadmium logger publishing live metrics of the City Water Supply model
+ *
+ * While the run is in progress, one JSON line of metrics (simulation time,
+ * reservoir levels, active, waiting and blocked pumps, blockages so far and
+ * simulation steps per second) is written at most every interval to a file
+ * (read it with tail -f) or to every client of a Unix domain socket (e.g.
+ * nc -U <path>). The clock is read a few times per interval, every 1 to 256
+ * steps depending on how long the steps take, and the socket is never waited
+ * on: clients are accepted and written to without blocking, a client that
+ * cannot keep up misses lines. Disabled unless open_file() or
+ * open_socket() was called.
+**/
+
+#ifndef _LIVE_METRICS_HPP__
+#define _LIVE_METRICS_HPP__
+
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+template<typename TIME> struct live_metrics {
+    using clock = chrono::steady_clock;
+    // Last state of a model, parsed only when its text changes
+    struct model_track {
+        string state;
+        bool   reservoir = false;
+        float  level = 0;
+        bool   active = false;
+        bool   wait = false;
+        bool   blockage = false;
+    };
+    struct data_type {
+        bool   enabled = false;
+        FILE * file = nullptr;
+        int    listen_fd = -1;
+        string socket_path;
+        vector<int> clients;
+        clock::duration   interval = chrono::milliseconds(250);
+        clock::time_point last_publish;
+        clock::time_point last_check;
+        long long stride = 1;     // Steps between two reads of the clock
+        long long next_check = 0; // Step at which the clock is read next
+        long long steps = 0;
+        long long steps_at_publish = 0;
+        long long blockages = 0; // Since the start of the run
+        TIME      now;
+        unordered_map<string, model_track> models;
+    };
+    static inline data_type data;
+
+    static void open_file(const string& path, int interval_ms) {
+        data.file = fopen(path.c_str(), "w");
+        if (!data.file) throw runtime_error("Cannot open live metrics file " + path);
+        start(interval_ms);
+    }
+    static void open_socket(const string& path, int interval_ms) {
+        sockaddr_un address = {};
+        if (path.size() >= sizeof(address.sun_path)) throw runtime_error("Socket path too long " + path);
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, path.c_str());
+        unlink(path.c_str());
+        data.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (data.listen_fd < 0 || bind(data.listen_fd, (sockaddr *) &address, sizeof(address)) != 0 || listen(data.listen_fd, 8) != 0) {
+            throw runtime_error("Cannot listen on " + path + ": " + strerror(errno));
+        }
+        data.socket_path = path;
+        start(interval_ms);
+    }
+    // Publishes the final metrics and closes the file or the socket
+    static void finish() {
+        if (!data.enabled) return;
+        publish();
+        if (data.file) fclose(data.file);
+        for (int client : data.clients) close(client);
+        if (data.listen_fd >= 0) {
+            close(data.listen_fd);
+            unlink(data.socket_path.c_str());
+        }
+        data = data_type();
+    }
+
+    template<typename DECLARED_SOURCE, typename... FORMATS, typename... PARAMs>
+    static void log(const PARAMs&... ps) {
+        if (!data.enabled) return;
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_state>::value) record_state(ps...);
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_global_time>::value) {
+            if (++data.steps >= data.next_check) check_clock();
+        }
+    }
+
+    static void record_state(const TIME& t, const string& model_id, const string& model_state) {
+        data.now = t;
+        model_track& m = data.models[model_id];
+        if (m.state == model_state) return;
+        m.state = model_state;
+        size_t pos;
+        if ((pos = model_state.find("level: ")) != string::npos) { // Reservoir
+            m.reservoir = true;
+            m.level = strtof(model_state.c_str() + pos + 7, nullptr);
+        } else if ((pos = model_state.find("active: ")) != string::npos) { // Water supply pump or city pump
+            m.active = model_state[pos + 8] == '1';
+            pos = model_state.find("waiting: ");
+            m.wait = pos != string::npos && model_state[pos + 9] == '1';
+            pos = model_state.find("blockage: ");
+            bool blockage = pos != string::npos && model_state[pos + 10] == '1';
+            if (blockage && !m.blockage) data.blockages++;
+            m.blockage = blockage;
+        }
+    }
+    template<typename... PARAMs>
+    static void record_state(const PARAMs&... ps) {}
+
+    static void start(int interval_ms) {
+        data.interval = chrono::milliseconds(interval_ms);
+        data.last_publish = data.last_check = clock::now();
+        data.enabled = true;
+    }
+
+    // Aims at 4 to 8 reads of the clock per interval: the stride doubles while the reads come faster and halves when they come slower
+    static void check_clock() {
+        clock::time_point now = clock::now();
+        clock::duration since = now - data.last_check;
+        data.last_check = now;
+        if (since < data.interval / 8 && data.stride < 256) data.stride *= 2;
+        else if (since > data.interval / 4 && data.stride > 1) data.stride /= 2;
+        data.next_check = data.steps + data.stride;
+        if (now - data.last_publish >= data.interval) publish();
+    }
+
+    static string metrics_line() {
+        double seconds = chrono::duration<double>(clock::now() - data.last_publish).count();
+        int active = 0, waiting = 0, blocked = 0;
+        vector<pair<string, float>> levels;
+        for (const auto& m : data.models) {
+            if (m.second.reservoir) levels.emplace_back(m.first, m.second.level);
+            active += m.second.active;
+            waiting += m.second.wait;
+            blocked += m.second.blockage;
+        }
+        sort(levels.begin(), levels.end());
+        ostringstream oss;
+        oss << "{\"time\":\"" << data.now << "\",\"levels\":{";
+        for (size_t i = 0; i < levels.size(); i++) oss << (i ? "," : "") << "\"" << levels[i].first << "\":" << levels[i].second;
+        oss << "},\"active_pumps\":" << active << ",\"waiting_pumps\":" << waiting << ",\"blocked_pumps\":" << blocked
+            << ",\"blockages\":" << data.blockages << ",\"steps\":" << data.steps
+            << ",\"steps_per_s\":" << (long long) (seconds > 0 ? (data.steps - data.steps_at_publish) / seconds : 0) << "}\n";
+        return oss.str();
+    }
+
+    static void publish() {
+        if (data.listen_fd >= 0) {
+            for (int client; (client = accept4(data.listen_fd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0;) data.clients.push_back(client);
+        }
+        if (data.file || !data.clients.empty()) {
+            string line = metrics_line();
+            if (data.file) {
+                fputs(line.c_str(), data.file);
+                fflush(data.file);
+            }
+            // A line that does not fit in the socket buffer is dropped, a client closed or left with half a line is disconnected
+            for (size_t i = 0; i < data.clients.size();) {
+                ssize_t sent = send(data.clients[i], line.data(), line.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (sent == (ssize_t) line.size() || (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+                    i++;
+                } else {
+                    close(data.clients[i]);
+                    data.clients.erase(data.clients.begin() + i);
+                }
+            }
+        }
+        data.last_publish = clock::now();
+        data.steps_at_publish = data.steps;
+    }
+};
+#endif // _LIVE_METRICS_HPP__
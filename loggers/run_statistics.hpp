@@ -0,0 +1,274 @@
+/**
+ * Cadmium logger collecting run statistics of the City Water Supply model
+ *
+ * Instead of writing the state log it keeps, per run, the minimum reservoir
+ * level and the time the supply pumps spend waiting or blocked. The data is
+ * thread_local so independent runs can be simulated concurrently.
+ *
+ * Every reservoir and pump also gets a fixed size record, updated as the
+ * logs come in: minimum, maximum and time weighted mean level of the
+ * reservoirs, volume pumped (from the flow messages) and, for the supply
+ * pumps, the fraction of the time waiting and the count and duration of the
+ * blockages. write_summary() saves them in a small CSV file, so long or
+ * batch runs do not need the full logs.
+ *
+ * Nothing is recorded until reset() is called. merge() adds the data of
+ * runs over disjoint sets of models, e.g. the partitions of a network.
+**/
+
+#ifndef _RUN_STATISTICS_HPP__
+#define _RUN_STATISTICS_HPP__
+
+#include <cadmium/logger/common_loggers.hpp>
+
+#include "../atomics/tick_time.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+using namespace std;
+using namespace cadmium;
+
+template<typename TIME> struct run_statistics {
+    // Level of a reservoir since its last change
+    struct reservoir_track {
+        float  level;
+        TIME   since;
+        TIME   first;        // First time the reservoir was logged
+        float  min_level;
+        float  max_level;
+        double level_seconds; // Integral of the level over time
+    };
+    // Status of a pump since its last change, only the supply pumps log blockages and waits
+    struct pump_track {
+        bool   supply;
+        bool   has_state;
+        bool   wait;
+        bool   blockage;
+        TIME   wait_since;
+        TIME   blockage_since;
+        TIME   first;         // First time the pump was logged
+        double wait_seconds;
+        double blockage_seconds;
+        long   blockages;
+        double volume;        // m^3
+        double rate;          // m^3/s, only with flow_rates
+        TIME   rate_since;
+    };
+    // Statistics of one run
+    struct data_type {
+        bool   enabled = false;
+        bool   flow_rates;       // Flow messages are rate changes (continuous mode) instead of volumes
+        float  min_level;
+        double wait_seconds;     // Summed over all supply pumps
+        double blockage_seconds; // Summed over all supply pumps
+        TIME   until;
+        unordered_map<string, reservoir_track> reservoirs;
+        unordered_map<string, pump_track> pumps;
+    };
+    static inline thread_local data_type data;
+
+    static void reset(bool flow_rates = false) {
+        data.enabled = true;
+        data.flow_rates = flow_rates;
+        data.min_level = numeric_limits<float>::infinity();
+        data.wait_seconds = 0;
+        data.blockage_seconds = 0;
+        data.reservoirs.clear();
+        data.pumps.clear();
+    }
+    // Closes the intervals still open when the run stops
+    static void finish(const TIME& t) {
+        if (!data.enabled) return;
+        data.until = t;
+        for (auto& r : data.reservoirs) {
+            r.second.level_seconds += r.second.level * time_to_seconds(t - r.second.since);
+            r.second.since = t;
+        }
+        for (auto& p : data.pumps) {
+            close_wait(p.second, t);
+            close_blockage(p.second, t);
+            close_rate(p.second, t);
+        }
+    }
+
+    // Adds the models of <other>, a run of other models until the same time, to <into>
+    static void merge(data_type& into, const data_type& other) {
+        if (!other.enabled) return;
+        if (other.min_level < into.min_level) into.min_level = other.min_level;
+        into.wait_seconds += other.wait_seconds;
+        into.blockage_seconds += other.blockage_seconds;
+        into.reservoirs.insert(other.reservoirs.begin(), other.reservoirs.end());
+        into.pumps.insert(other.pumps.begin(), other.pumps.end());
+    }
+
+    template<typename DECLARED_SOURCE, typename... FORMATS, typename... PARAMs>
+    static void log(const PARAMs&... ps) {
+        if (!data.enabled) return;
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_state>::value) record_state(ps...);
+        if constexpr (is_same<DECLARED_SOURCE, logger::logger_messages>::value) record_messages(ps...);
+    }
+
+    static void record_state(const TIME& t, const string& model_id, const string& model_state) {
+        size_t pos;
+        if ((pos = model_state.find("level: ")) != string::npos) { // Reservoir
+            float level = strtof(model_state.c_str() + pos + 7, nullptr);
+            if (level < data.min_level) data.min_level = level;
+            auto it = data.reservoirs.find(model_id);
+            if (it == data.reservoirs.end()) {
+                data.reservoirs.emplace(model_id, reservoir_track{level, t, t, level, level, 0});
+                return;
+            }
+            reservoir_track& r = it->second;
+            if (level != r.level) {
+                r.level_seconds += r.level * time_to_seconds(t - r.since);
+                r.level = level;
+                r.since = t;
+                if (level < r.min_level) r.min_level = level;
+                if (level > r.max_level) r.max_level = level;
+            }
+        } else if ((pos = model_state.find("blockage: ")) != string::npos) { // Water supply pump
+            bool blockage = model_state[pos + 10] == '1';
+            pos = model_state.find("waiting: ");
+            bool wait = pos != string::npos && model_state[pos + 9] == '1';
+            pump_track& p = pump(model_id, t, true);
+            if (!p.has_state) {
+                p.has_state = true;
+                p.wait = wait;
+                p.blockage = blockage;
+                p.wait_since = p.blockage_since = t;
+                if (blockage) p.blockages++;
+                return;
+            }
+            if (wait != p.wait) {
+                close_wait(p, t);
+                p.wait = wait;
+            }
+            if (blockage != p.blockage) {
+                close_blockage(p, t);
+                p.blockage = blockage;
+                if (blockage) p.blockages++;
+            }
+        }
+    }
+    template<typename... PARAMs>
+    static void record_state(const PARAMs&... ps) {}
+
+    // Messages come as "[port: {v1, v2}, port: {...}]", only the flow ports of the pumps are read
+    static void record_messages(const TIME& t, const string& model_id, const string& messages) {
+        static const string supply_flow = "WaterSupplyPump_defs::flow: {";
+        static const string city_flow = "CityPump_defs::flow: {";
+        size_t pos;
+        bool supply;
+        if ((pos = messages.find(supply_flow)) != string::npos) {
+            supply = true;
+            pos += supply_flow.size();
+        } else if ((pos = messages.find(city_flow)) != string::npos) {
+            supply = false;
+            pos += city_flow.size();
+        } else {
+            return;
+        }
+        double sum = 0;
+        const char * p = messages.c_str() + pos;
+        char * end;
+        while (*p != '}' && *p != '\0') {
+            double value = strtod(p, &end);
+            if (end == p) break;
+            sum += value;
+            p = end;
+            while (*p == ',' || *p == ' ') p++;
+        }
+        if (sum == 0) return;
+        pump_track& track = pump(model_id, t, supply);
+        if (data.flow_rates) {
+            close_rate(track, t);
+            track.rate += sum;
+        } else {
+            track.volume += sum;
+        }
+    }
+    template<typename... PARAMs>
+    static void record_messages(const PARAMs&... ps) {}
+
+    // One "model,statistic,value" line per figure, models sorted by id, after finish()
+    static void write_summary(const string& path) {
+        ofstream os(path);
+        if (!os) throw runtime_error("Cannot open " + path);
+        map<string, const reservoir_track*> reservoirs;
+        for (const auto& r : data.reservoirs) reservoirs[r.first] = &r.second;
+        map<string, const pump_track*> pumps;
+        for (const auto& p : data.pumps) pumps[p.first] = &p.second;
+
+        os << "model,statistic,value" << endl;
+        os << "run,until_seconds," << time_to_seconds(data.until) << endl;
+        os << "run,supply_volume," << volume(true) << endl;
+        os << "run,city_volume," << volume(false) << endl;
+        os << "run,wait_minutes," << data.wait_seconds / 60.0 << endl;
+        os << "run,blockage_minutes," << data.blockage_seconds / 60.0 << endl;
+        for (const auto& r : reservoirs) {
+            os << r.first << ",min_level," << r.second->min_level << endl;
+            os << r.first << ",max_level," << r.second->max_level << endl;
+            os << r.first << ",mean_level," << mean_level(*r.second) << endl;
+        }
+        for (const auto& p : pumps) {
+            os << p.first << ",volume," << p.second->volume << endl;
+            if (!p.second->supply) continue;
+            double duration = time_to_seconds(data.until - p.second->first);
+            os << p.first << ",wait_fraction," << (duration > 0 ? p.second->wait_seconds / duration : 0) << endl;
+            os << p.first << ",blockages," << p.second->blockages << endl;
+            os << p.first << ",blockage_minutes," << p.second->blockage_seconds / 60.0 << endl;
+        }
+    }
+
+    // Total volume pumped by the supply pumps or by the city pumps
+    static double volume(bool supply) {
+        double total = 0;
+        for (const auto& p : data.pumps) {
+            if (p.second.supply == supply) total += p.second.volume;
+        }
+        return total;
+    }
+    // Time weighted mean level of a reservoir, after finish()
+    static double mean_level(const reservoir_track& r) {
+        double duration = time_to_seconds(data.until - r.first);
+        return duration > 0 ? r.level_seconds / duration : r.level;
+    }
+
+    static pump_track& pump(const string& model_id, const TIME& t, bool supply) {
+        auto it = data.pumps.find(model_id);
+        if (it == data.pumps.end()) {
+            it = data.pumps.emplace(model_id, pump_track{supply, false, false, false, t, t, t, 0, 0, 0, 0, 0, t}).first;
+        }
+        return it->second;
+    }
+    static void close_wait(pump_track& p, const TIME& t) {
+        if (p.wait) {
+            double s = time_to_seconds(t - p.wait_since);
+            p.wait_seconds += s;
+            data.wait_seconds += s;
+        }
+        p.wait_since = t;
+    }
+    static void close_blockage(pump_track& p, const TIME& t) {
+        if (p.blockage) {
+            double s = time_to_seconds(t - p.blockage_since);
+            p.blockage_seconds += s;
+            data.blockage_seconds += s;
+        }
+        p.blockage_since = t;
+    }
+    static void close_rate(pump_track& p, const TIME& t) {
+        if (p.rate != 0) p.volume += p.rate * time_to_seconds(t - p.rate_since);
+        p.rate_since = t;
+    }
+};
+#endif // _RUN_STATISTICS_HPP__
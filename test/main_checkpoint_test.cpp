@@ -0,0 +1,98 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model headers
+#include "../top_model/city_supply.hpp"
+#include "../top_model/checkpoint.hpp"
+
+//C++ libraries
+#include <iostream>
+#include <fstream>
+#include <string>
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+using TIME = time_type;
+
+/*************** Loggers, writing nothing until a run reaches the checkpoint time *******************/
+static ostream discard(nullptr);
+static ostream * out_messages = &discard;
+static ostream * out_state = &discard;
+struct oss_sink_messages{
+    static ostream& sink(){
+        return *out_messages;
+    }
+};
+struct oss_sink_state{
+    static ostream& sink(){
+        return *out_state;
+    }
+};
+
+using state=logger::logger<logger::logger_state, dynamic::logger::formatter<TIME>, oss_sink_state>;
+using log_messages=logger::logger<logger::logger_messages, dynamic::logger::formatter<TIME>, oss_sink_messages>;
+using global_time_mes=logger::logger<logger::logger_global_time, dynamic::logger::formatter<TIME>, oss_sink_messages>;
+using global_time_sta=logger::logger<logger::logger_global_time, dynamic::logger::formatter<TIME>, oss_sink_state>;
+
+using logger_top=logger::multilogger<state, log_messages, global_time_mes, global_time_sta>;
+
+// Runs the TOP model uninterrupted, then stopped at 12:00, saved, restored and run again: both logs from 12:00 on must match (bin/COMPARE_RESULTS, see make check)
+int main(){
+
+    TIME checkpoint_time("12:00:00:000");
+    TIME until("24:00:00:000");
+    const char * checkpoint_path = "../simulation_results/checkpoint_test.bin";
+
+    /****** Input files, loaded once and read by the three runs *******************/
+    shared_ptr<const binary_input_file> pumps_input  = load_input("../input_data/city_pump_instr.txt");
+    shared_ptr<const binary_input_file> supply_input = load_input("../input_data/water_supply_instr.txt");
+
+    /****** Uninterrupted run, logged from the checkpoint time on *******************/
+    static ofstream uninterrupted_messages("../simulation_results/checkpoint_test_output_messages.txt");
+    static ofstream uninterrupted_state("../simulation_results/checkpoint_test_output_state.txt");
+    {
+        shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_city_supply<TIME>(
+            make_input_reader<TIME>("pumps_input_reader", pumps_input), make_input_reader<TIME>("supply_input_reader", supply_input));
+        dynamic::engine::runner<TIME, logger_top> r(TOP, {0});
+        r.run_until(checkpoint_time);
+        out_messages = &uninterrupted_messages;
+        out_state = &uninterrupted_state;
+        r.run_until(until);
+    }
+
+    /****** Run stopped at the checkpoint time and saved *******************/
+    out_messages = &discard;
+    out_state = &discard;
+    {
+        shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_city_supply<TIME, Reservoir, WaterSupplyPump, CityPump, true>(
+            make_input_reader<TIME, true>("pumps_input_reader", pumps_input), make_input_reader<TIME, true>("supply_input_reader", supply_input));
+        dynamic::engine::runner<TIME, logger_top> r(TOP, {0});
+        r.run_until(checkpoint_time);
+        save_checkpoint(TOP, checkpoint_time, checkpoint_path);
+    }
+
+    /****** Run restored from the checkpoint, logged once started *******************/
+    static ofstream restored_messages("../simulation_results/checkpoint_test_restored_output_messages.txt");
+    static ofstream restored_state("../simulation_results/checkpoint_test_restored_output_state.txt");
+    {
+        checkpoint_data resumed = read_checkpoint<TIME>(checkpoint_path);
+        shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_city_supply<TIME, Reservoir, WaterSupplyPump, CityPump, true>(
+            make_input_reader<TIME, true>("pumps_input_reader", resumed.input("pumps_input_reader")),
+            make_input_reader<TIME, true>("supply_input_reader", resumed.input("supply_input_reader")));
+        restore_checkpoint(TOP, resumed);
+        dynamic::engine::runner<TIME, logger_top> r(TOP, resumed.start_time<TIME>());
+        out_messages = &restored_messages;
+        out_state = &restored_state;
+        r.run_until(until);
+    }
+    return 0;
+}
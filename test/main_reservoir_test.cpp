@@ -20,7 +20,7 @@ using namespace std;
 using namespace cadmium;
 using namespace cadmium::basic_models::pdevs;
 
-using TIME = NDTime;
+using TIME = time_type;
 
 /***** Define input port for coupled models *****/
 
@@ -29,10 +29,10 @@ struct top_out: public out_port<float>{};
 
 /****** Input Reader atomic model declaration *******************/
 template<typename T>
-class InputReader_Flow : public iestream_input<float,T> {
+class InputReader_Flow : public iestream_input<volume_type,T> {
     public:
         InputReader_Flow () = default;
-        InputReader_Flow (const char* file_path) : iestream_input<float,T>(file_path) {}
+        InputReader_Flow (const char* file_path) : iestream_input<volume_type,T>(file_path) {}
 };
 
 int main(){
@@ -64,8 +64,8 @@ int main(){
     };
     dynamic::modeling::ICs ics_TOP;
     ics_TOP = {
-        dynamic::translate::make_IC<iestream_input_defs<float>::out,Reservoir_defs::flow_in>("flow_in_input_reader","reservoir1"),
-        dynamic::translate::make_IC<iestream_input_defs<float>::out,Reservoir_defs::flow_out>("flow_out_input_reader","reservoir1")
+        dynamic::translate::make_IC<iestream_input_defs<volume_type>::out,Reservoir_defs::flow_in>("flow_in_input_reader","reservoir1"),
+        dynamic::translate::make_IC<iestream_input_defs<volume_type>::out,Reservoir_defs::flow_out>("flow_out_input_reader","reservoir1")
     };
     shared_ptr<dynamic::modeling::coupled<TIME>> TOP;
     TOP = make_shared<dynamic::modeling::coupled<TIME>>(
@@ -94,7 +94,7 @@ int main(){
     using logger_top=logger::multilogger<state, log_messages, global_time_mes, global_time_sta>;
 
     /************** Runner call ************************/ 
-    dynamic::engine::runner<NDTime, logger_top> r(TOP, {0});
-    r.run_until(NDTime("01:00:00:000"));
+    dynamic::engine::runner<TIME, logger_top> r(TOP, {0});
+    r.run_until(TIME("01:00:00:000"));
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -21,12 +21,12 @@ using namespace std;
 using namespace cadmium;
 using namespace cadmium::basic_models::pdevs;
 
-using TIME = NDTime;
+using TIME = time_type;
 
 /***** Define input port for coupled models *****/
 
 /***** Define output ports for coupled model *****/
-struct top_out_flow: public out_port<float>{}; // Flow
+struct top_out_flow: public out_port<volume_type>{}; // Flow
 struct top_out_lvl:  public out_port<float>{}; // Level
 
 /****** Input Reader atomic model declaration *******************/
@@ -98,7 +98,7 @@ int main(){
     using logger_top=logger::multilogger<state, log_messages, global_time_mes, global_time_sta>;
 
     /************** Runner call ************************/ 
-    dynamic::engine::runner<NDTime, logger_top> r(TOP, {0});
-    r.run_until(NDTime("06:00:00:000"));
+    dynamic::engine::runner<TIME, logger_top> r(TOP, {0});
+    r.run_until(TIME("06:00:00:000"));
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
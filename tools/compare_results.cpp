@@ -0,0 +1,236 @@
+/**
+ * Compares two text logs of the Cadmium loggers (state or messages) field by
+ * field instead of byte by byte: the steps are matched by time, the records
+ * of a time by model, and the values by field name, numbers within a
+ * relative tolerance. Both files are read one time at a time, so month long
+ * logs are compared in the memory of a single time.
+ *
+ * Exit status 0 when the logs match, 1 when they differ, 2 on bad usage.
+**/
+
+//C++ headers
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// One log line: model id and its named values (state fields, or message ports with their bag)
+struct record {
+    string model;
+    vector<pair<string, string>> fields;
+};
+
+// Records of one time, by model in the order they were logged
+using time_records = map<string, vector<record>>;
+
+bool is_time(const string& line) {
+    if (line == "inf") return true;
+    return !line.empty() && isdigit((unsigned char) line[0]) && line.find_first_not_of("0123456789:") == string::npos;
+}
+
+long long time_ms(const string& time) {
+    if (time == "inf") return numeric_limits<long long>::max();
+    long long h = 0, m = 0, s = 0, ms = 0;
+    sscanf(time.c_str(), "%lld:%lld:%lld:%lld", &h, &m, &s, &ms);
+    return ((h * 60 + m) * 60 + s) * 1000 + ms;
+}
+
+// "State for model <id> is <field>: <value> & ...", "[<port>: {<values>}, ...] generated by model <id>", anything else compared as text
+record parse_record(const string& line) {
+    static const string state_prefix = "State for model ", state_infix = " is ", message_suffix = "] generated by model ";
+    record r;
+    size_t pos;
+    if (line.compare(0, state_prefix.size(), state_prefix) == 0 && (pos = line.find(state_infix, state_prefix.size())) != string::npos) {
+        r.model = line.substr(state_prefix.size(), pos - state_prefix.size());
+        string fields = line.substr(pos + state_infix.size());
+        for (size_t start = 0; start <= fields.size();) {
+            size_t end = fields.find(" & ", start);
+            if (end == string::npos) end = fields.size();
+            string field = fields.substr(start, end - start);
+            size_t colon = field.find(": ");
+            if (colon == string::npos) r.fields.emplace_back("", field);
+            else r.fields.emplace_back(field.substr(0, colon), field.substr(colon + 2));
+            start = end + 3;
+        }
+    } else if (!line.empty() && line[0] == '[' && (pos = line.rfind(message_suffix)) != string::npos) {
+        r.model = line.substr(pos + message_suffix.size());
+        string ports = line.substr(1, pos - 1);
+        for (size_t start = 0; start < ports.size();) {
+            size_t open = ports.find(": {", start);
+            size_t close = open == string::npos ? string::npos : ports.find('}', open);
+            if (close == string::npos) {
+                r.fields.emplace_back("", ports.substr(start));
+                break;
+            }
+            r.fields.emplace_back(ports.substr(start, open - start), ports.substr(open + 3, close - open - 3));
+            start = close + 1;
+            while (start < ports.size() && (ports[start] == ',' || ports[start] == ' ')) start++;
+        }
+    } else {
+        r.fields.emplace_back("", line);
+    }
+    return r;
+}
+
+// Reads a log one time at a time, consecutive time lines with the same time are merged
+struct log_reader {
+    ifstream file;
+    string next_time; // Time line already read, starting the next time
+    bool done = false;
+
+    explicit log_reader(const string& path) : file(path) {
+        string line;
+        while (getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (is_time(line)) break;
+        }
+        if (file) next_time = line;
+        else done = true;
+    }
+    bool next(string& time, time_records& records) {
+        records.clear();
+        if (done) return false;
+        time = next_time;
+        string line;
+        while (getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (is_time(line)) {
+                if (line == time) continue;
+                next_time = line;
+                return true;
+            }
+            if (line.empty()) continue;
+            record r = parse_record(line);
+            records[r.model].push_back(move(r));
+        }
+        done = true;
+        return true;
+    }
+};
+
+struct comparison {
+    double tolerance;
+    long long max_reported;
+    long long differences = 0;
+    long long times = 0;
+    long long records = 0;
+
+    void report(const string& time, const string& what) {
+        if (differences++ < max_reported) cout << time << " " << what << endl;
+    }
+    bool same_value(const string& expected, const string& actual) const {
+        if (expected == actual) return true;
+        char * end_e;
+        char * end_a;
+        double e = strtod(expected.c_str(), &end_e);
+        double a = strtod(actual.c_str(), &end_a);
+        if (*end_e != '\0' || *end_a != '\0' || end_e == expected.c_str() || end_a == actual.c_str()) return false;
+        return fabs(e - a) <= tolerance * max(1.0, max(fabs(e), fabs(a)));
+    }
+    // Bags are compared value by value
+    bool same_values(const string& expected, const string& actual) const {
+        size_t pe = 0, pa = 0;
+        for (;;) {
+            size_t ee = expected.find(", ", pe), ea = actual.find(", ", pa);
+            if (!same_value(expected.substr(pe, ee - pe), actual.substr(pa, ea - pa))) return false;
+            if (ee == string::npos || ea == string::npos) return ee == ea;
+            pe = ee + 2;
+            pa = ea + 2;
+        }
+    }
+    void compare(const string& time, const time_records& expected, const time_records& actual) {
+        times++;
+        auto e = expected.begin(), a = actual.begin();
+        while (e != expected.end() || a != actual.end()) {
+            if (a == actual.end() || (e != expected.end() && e->first < a->first)) {
+                report(time, "model " + e->first + ": only in expected (" + to_string(e->second.size()) + " records)");
+                ++e;
+            } else if (e == expected.end() || a->first < e->first) {
+                report(time, "model " + a->first + ": only in actual (" + to_string(a->second.size()) + " records)");
+                ++a;
+            } else {
+                compare(time, e->first, e->second, a->second);
+                ++e;
+                ++a;
+            }
+        }
+    }
+    void compare(const string& time, const string& model, const vector<record>& expected, const vector<record>& actual) {
+        if (expected.size() != actual.size()) {
+            report(time, "model " + model + ": " + to_string(expected.size()) + " records expected, " + to_string(actual.size()) + " found");
+        }
+        for (size_t i = 0; i < min(expected.size(), actual.size()); i++) {
+            records++;
+            string where = "model " + model + (expected.size() > 1 ? " #" + to_string(i + 1) : "");
+            const auto& fe = expected[i].fields;
+            const auto& fa = actual[i].fields;
+            for (const auto& field : fe) {
+                auto found = find_if(fa.begin(), fa.end(), [&](const pair<string, string>& f) { return f.first == field.first; });
+                if (found == fa.end()) report(time, where + " " + field.first + ": missing, expected " + field.second);
+                else if (!same_values(field.second, found->second)) report(time, where + " " + field.first + ": expected " + field.second + ", actual " + found->second);
+            }
+            for (const auto& field : fa) {
+                auto found = find_if(fe.begin(), fe.end(), [&](const pair<string, string>& f) { return f.first == field.first; });
+                if (found == fe.end()) report(time, where + " " + field.first + ": unexpected, actual " + field.second);
+            }
+        }
+    }
+};
+
+int main(int argc, char ** argv) {
+
+    vector<string> args;
+    double tolerance = 1e-5;
+    long long max_reported = 20;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--tolerance=", 12) == 0) tolerance = atof(argv[i] + 12);
+        else if (strncmp(argv[i], "--max-diffs=", 12) == 0) max_reported = atoll(argv[i] + 12);
+        else args.push_back(argv[i]);
+    }
+    if (args.size() != 2) {
+        cout << "Program used with wrong parameters. The program must be invoked as follow:";
+        cout << argv[0] << " path to the expected log, path to the actual log [--tolerance=<relative>] [--max-diffs=<n>] " << endl;
+        return 2;
+    }
+    log_reader expected(args[0]), actual(args[1]);
+    if (!expected.file.is_open() || !actual.file.is_open()) {
+        cout << "Cannot read " << (expected.file.is_open() ? args[1] : args[0]) << endl;
+        return 2;
+    }
+
+    /****** Times are walked in order in both logs, a time missing on one side is reported and skipped *******************/
+    comparison c = {tolerance, max_reported};
+    string time_e, time_a;
+    time_records records_e, records_a;
+    bool has_e = expected.next(time_e, records_e);
+    bool has_a = actual.next(time_a, records_a);
+    while (has_e || has_a) {
+        long long te = has_e ? time_ms(time_e) : numeric_limits<long long>::max();
+        long long ta = has_a ? time_ms(time_a) : numeric_limits<long long>::max();
+        if (has_e && (!has_a || te < ta)) {
+            c.report(time_e, "only in expected (" + to_string(records_e.size()) + " models)");
+            has_e = expected.next(time_e, records_e);
+        } else if (has_a && (!has_e || ta < te)) {
+            c.report(time_a, "only in actual (" + to_string(records_a.size()) + " models)");
+            has_a = actual.next(time_a, records_a);
+        } else {
+            c.compare(time_e, records_e, records_a);
+            has_e = expected.next(time_e, records_e);
+            has_a = actual.next(time_a, records_a);
+        }
+    }
+    if (c.differences > max_reported) cout << "... " << c.differences - max_reported << " more" << endl;
+    cout << args[1] << ": " << c.times << " times, " << c.records << " records compared with " << args[0] << ", "
+         << c.differences << " differences" << endl;
+    return c.differences ? 1 : 0;
+}
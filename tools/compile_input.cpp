@@ -0,0 +1,46 @@
+/**
+ * Compiles a text input file of the input readers (one "time value" command
+ * per line, time as hh:mm:ss[:mmm]) into the binary format read by
+ * BinaryInputReader (see atomics/binary_input_format.hpp). Commands are
+ * sorted by time, commands at the same time keep the order of the file.
+**/
+
+#include "../atomics/binary_input_format.hpp"
+
+//C++ headers
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char ** argv) {
+
+    if (argc < 3) {
+        cout << "Program used with wrong parameters. The program must be invoked as follow:";
+        cout << argv[0] << " path to the text input file, path to the binary output " << endl;
+        return 1;
+    }
+    vector<binary_input::record> records;
+    try {
+        records = binary_input::read_text(argv[1]);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    binary_input::header h = {};
+    memcpy(h.magic, binary_input::magic, sizeof(h.magic));
+    h.version = binary_input::version;
+    h.record_size = sizeof(binary_input::record);
+    h.record_count = records.size();
+    FILE * out = fopen(argv[2], "wb");
+    if (!out || fwrite(&h, sizeof(h), 1, out) != 1
+            || fwrite(records.data(), sizeof(binary_input::record), records.size(), out) != records.size() || fclose(out) != 0) {
+        cerr << "Cannot write " << argv[2] << endl;
+        return 1;
+    }
+    cout << records.size() << " commands written to " << argv[2] << endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * Converts a binary state log (see loggers/binary_state_format.hpp) back to
+ * the text state log written by the Cadmium text loggers, for diffing.
+ * The file is memory mapped and its little endian records are decoded in
+ * place.
+**/
+
+#include "../loggers/binary_state_format.hpp"
+
+//C++ headers
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//POSIX headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Reads a footer string table, returns the position right after it or nullptr if it overruns the file
+const char * read_strings(const char * pos, const char * end, vector<string>& strings) {
+    if (end - pos < 4) return nullptr;
+    uint32_t count = binary_state::get<uint32_t>(pos);
+    pos += 4;
+    for (uint32_t i = 0; i < count; i++) {
+        if (end - pos < 4) return nullptr;
+        uint32_t length = binary_state::get<uint32_t>(pos);
+        pos += 4;
+        if (end - pos < (long) length) return nullptr;
+        strings.emplace_back(pos, length);
+        pos += length;
+    }
+    return pos;
+}
+
+int main(int argc, char ** argv) {
+
+    if (argc < 2) {
+        cout << "Program used with wrong parameters. The program must be invoked as follow:";
+        cout << argv[0] << " path to the binary state log [, path to the text output] " << endl;
+        return 1;
+    }
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t) binary_state::header_size) {
+        cerr << "Cannot read " << argv[1] << endl;
+        return 1;
+    }
+    const char * data = static_cast<const char *>(mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    if (data == MAP_FAILED) {
+        cerr << "Cannot map " << argv[1] << endl;
+        return 1;
+    }
+    const char * end = data + st.st_size;
+
+    binary_state::header h = binary_state::read_header(data);
+    if (memcmp(h.magic, binary_state::magic, sizeof(h.magic)) != 0 || h.version != binary_state::version
+            || h.record_size != binary_state::record_size || h.footer_offset == 0
+            || h.footer_offset != binary_state::header_size + h.record_count * h.record_size || h.footer_offset > (uint64_t) st.st_size) {
+        cerr << argv[1] << " is not a complete binary state log (version " << binary_state::version << ")" << endl;
+        return 1;
+    }
+    vector<string> models, texts;
+    const char * footer = read_strings(data + h.footer_offset, end, models);
+    if (!footer || !read_strings(footer, end, texts)) {
+        cerr << argv[1] << " has a corrupted footer" << endl;
+        return 1;
+    }
+
+    ofstream out_file;
+    if (argc > 2) out_file.open(argv[2]);
+    ostream& out = argc > 2 ? out_file : cout;
+
+    const char * records = data + binary_state::header_size;
+    for (uint64_t i = 0; i < h.record_count; i++) {
+        binary_state::record r = binary_state::read_record(records + i * binary_state::record_size);
+        if (r.kind == binary_state::time_step) {
+            out << binary_state::time_to_string(r.time) << '\n';
+            continue;
+        }
+        out << "State for model " << models.at(r.model) << " is ";
+        switch (r.kind) {
+            case binary_state::reservoir:
+                out << "volume: " << r.value[0] << " & level: " << r.value[1];
+                break;
+            case binary_state::water_supply_pump:
+                out << "active: " << ((r.flags & binary_state::active) != 0)
+                    << " & blockage: " << ((r.flags & binary_state::blockage) != 0)
+                    << " & waiting: " << ((r.flags & binary_state::wait) != 0);
+                break;
+            case binary_state::city_pump:
+                out << "active: " << ((r.flags & binary_state::active) != 0);
+                break;
+            default:
+                out << texts.at(r.text);
+        }
+        out << '\n';
+    }
+    munmap(const_cast<char *>(data), st.st_size);
+    close(fd);
+    return 0;
+}
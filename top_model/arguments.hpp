@@ -0,0 +1,43 @@
+/**
+ * Numbers given on the command line of the simulators
+ *
+ * The whole argument must be the number, in range: "0.1x", "", "-1" for an
+ * unsigned value or a count past its limits throw invalid_argument naming
+ * the argument, where atof()/atoi() would have read something else.
+**/
+
+#ifndef _ARGUMENTS_HPP__
+#define _ARGUMENTS_HPP__
+
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+inline double parse_double(const string& text, const string& name) {
+    char * end = nullptr;
+    errno = 0;
+    double value = strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || errno == ERANGE || !isfinite(value)) {
+        throw invalid_argument("Cannot parse " + name + " '" + text + "'");
+    }
+    return value;
+}
+
+inline unsigned long parse_unsigned(const string& text, const string& name, unsigned long min = 0, unsigned long max = UINT_MAX) {
+    char * end = nullptr;
+    errno = 0;
+    unsigned long value = strtoul(text.c_str(), &end, 10);
+    if (text.empty() || text.find('-') != string::npos || *end != '\0' || errno == ERANGE) {
+        throw invalid_argument("Cannot parse " + name + " '" + text + "'");
+    }
+    if (value < min || value > max) {
+        throw invalid_argument(name + " must be between " + to_string(min) + " and " + to_string(max) + ", got " + text);
+    }
+    return value;
+}
+#endif // _ARGUMENTS_HPP__
@@ -0,0 +1,156 @@
+/**
+ * Checkpoint and restore of a dynamic TOP model
+ *
+ * save_checkpoint() writes every atomic model of the TOP model (all built
+ * with CHECKPOINTED_IF(true, ...)) to a versioned binary file, see
+ * atomics/checkpointed.hpp for the format. To resume, read_checkpoint() reads
+ * the file and loads the input of every reader in memory: compiled inputs are
+ * mapped again, text inputs parsed, and their readers are restored as
+ * BinaryInputReader at the first command at or after the checkpoint time.
+ * The TOP model is then built again on those inputs (same ids and parameters
+ * as the saved one), restore_checkpoint() loads the states into it and the
+ * runner is started at the checkpoint time. Nothing is written but the
+ * checkpoint itself.
+**/
+
+#ifndef _CHECKPOINT_HPP__
+#define _CHECKPOINT_HPP__
+
+//Cadmium Simulator headers
+#include <cadmium/modeling/dynamic_model.hpp>
+
+//Atomic model headers
+#include "../atomics/checkpointed.hpp"
+#include "../atomics/binary_input_reader.hpp"
+
+//C++ headers
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace cadmium;
+
+struct checkpoint_data {
+    struct model {
+        checkpoint::kind kind;
+        string payload;
+    };
+    int64_t                                          time;   // Milliseconds
+    map<string, model>                               models; // By model id
+    map<string, shared_ptr<const binary_input_file>> inputs; // Input reader id -> its input, to build the reader on (make_input_reader)
+
+    template<typename TIME> TIME start_time() const { return ms_to_time<TIME>(time); }
+    const shared_ptr<const binary_input_file>& input(const string& id) const {
+        auto it = inputs.find(id);
+        if (it == inputs.end()) throw runtime_error("No input reader " + id + " in the checkpoint");
+        return it->second;
+    }
+};
+
+// Calls f on every atomic model of the coupled model, depth first in declaration order
+template<typename TIME>
+void for_each_atomic(const shared_ptr<dynamic::modeling::coupled<TIME>>& coupled, const function<void(dynamic::modeling::model&)>& f) {
+    for (const shared_ptr<dynamic::modeling::model>& m : coupled->_models) {
+        if (auto c = dynamic_pointer_cast<dynamic::modeling::coupled<TIME>>(m)) for_each_atomic(c, f);
+        else f(*m);
+    }
+}
+
+inline checkpointable& as_checkpointable(dynamic::modeling::model& m) {
+    checkpointable * c = dynamic_cast<checkpointable *>(&m);
+    if (!c) throw runtime_error("Model " + m.get_id() + " cannot be checkpointed");
+    return *c;
+}
+
+/****** Writes the state of every atomic model at time t, once the runner stopped at t *******************/
+template<typename TIME>
+void save_checkpoint(const shared_ptr<dynamic::modeling::coupled<TIME>>& top, const TIME& t, const string& path) {
+    ofstream out(path, ios::binary);
+    if (!out) throw runtime_error("Cannot write checkpoint " + path);
+    int64_t time = time_to_ms(t);
+    uint32_t model_count = 0;
+    for_each_atomic<TIME>(top, [&](dynamic::modeling::model&) { model_count++; });
+    checkpoint::writer record{out, time};
+    out.write(checkpoint::magic, sizeof(checkpoint::magic));
+    record.put<uint32_t>(checkpoint::version);
+    record.put<uint32_t>(model_count);
+    record.put<int64_t>(time);
+    for_each_atomic<TIME>(top, [&](dynamic::modeling::model& m) {
+        checkpointable& c = as_checkpointable(m);
+        ostringstream payload;
+        checkpoint::writer w{payload, time};
+        c.save(w);
+        record.put<uint16_t>(m.get_id().size());
+        out.write(m.get_id().data(), m.get_id().size());
+        record.put<uint8_t>(c.kind());
+        record.put_string(payload.str());
+    });
+    if (!out) throw runtime_error("Cannot write checkpoint " + path);
+}
+
+/****** Reads a checkpoint and loads the inputs of its readers *******************/
+template<typename TIME>
+checkpoint_data read_checkpoint(const string& path) {
+    ifstream in(path, ios::binary);
+    if (!in) throw runtime_error("Cannot open checkpoint " + path);
+    char magic[sizeof(checkpoint::magic)];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, checkpoint::magic, sizeof(magic)) != 0) throw runtime_error(path + " is not a checkpoint");
+    checkpoint::reader r{in, 0, false, 0, 0};
+    uint32_t version = r.get<uint32_t>();
+    if (version != checkpoint::version) throw runtime_error(path + ": unsupported checkpoint version " + to_string(version));
+    uint32_t model_count = r.get<uint32_t>();
+    checkpoint_data data;
+    data.time = r.time = r.get<int64_t>();
+    for (uint32_t i = 0; i < model_count; i++) {
+        string id(r.get<uint16_t>(), '\0');
+        if (!in.read(&id[0], id.size())) throw runtime_error(path + ": truncated checkpoint");
+        checkpoint::kind kind = (checkpoint::kind) r.get<uint8_t>();
+        checkpoint_data::model& m = data.models[id];
+        m = {kind, r.get_string()};
+        if (kind != checkpoint::input_reader && kind != checkpoint::binary_input_reader) continue;
+
+        istringstream payload(m.payload);
+        checkpoint::reader p{payload, data.time, false, 0, 0};
+        p.get<int64_t>();
+        string input_path = p.get_string();
+        data.inputs[id] = load_input(input_path);
+        if (kind == checkpoint::binary_input_reader) continue;
+
+        // A text reader goes on as a BinaryInputReader from its first command at or after the checkpoint time
+        const binary_input_file& input = *data.inputs[id];
+        uint64_t next = lower_bound(input.records, input.records + input.count, data.time,
+                                    [](const binary_input::record& record, int64_t time) { return record.time < time; }) - input.records;
+        ostringstream restarted;
+        checkpoint::writer w{restarted, data.time};
+        w.put<int64_t>(data.time);
+        w.put_string(input_path);
+        w.put<uint64_t>(next);
+        w.put<int64_t>(data.time);
+        m = {checkpoint::binary_input_reader, restarted.str()};
+    }
+    return data;
+}
+
+/****** Loads the checkpoint into a TOP model built like the saved one; reseed gives new random engines to branch scenarios *******************/
+template<typename TIME>
+void restore_checkpoint(const shared_ptr<dynamic::modeling::coupled<TIME>>& top, const checkpoint_data& data, bool reseed = false, unsigned int seed = 0) {
+    uint32_t engines = 0;
+    for_each_atomic<TIME>(top, [&](dynamic::modeling::model& m) {
+        checkpointable& c = as_checkpointable(m);
+        auto it = data.models.find(m.get_id());
+        if (it == data.models.end()) throw runtime_error("Model " + m.get_id() + " is not in the checkpoint");
+        if (it->second.kind != c.kind()) throw runtime_error("Model " + m.get_id() + " has another type in the checkpoint");
+        istringstream payload(it->second.payload);
+        checkpoint::reader r{payload, data.time, reseed, seed, engines};
+        c.load(r);
+        engines = r.engines;
+    });
+}
+#endif // _CHECKPOINT_HPP__
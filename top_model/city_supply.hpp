@@ -0,0 +1,152 @@
+/**
+ * Cadmium implementation of CD++ coupled models from City Water Supply
+ *
+ * Builds the dynamic TOP model (WaterSupply + PumpStation + input readers)
+ * so it can be shared between the simulator, the benchmarks and the drivers
+ * running many models (ensemble, parameter sweep).
+**/
+
+#ifndef _CITY_SUPPLY_HPP__
+#define _CITY_SUPPLY_HPP__
+
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+
+//Atomic model headers
+#include <cadmium/basic_model/pdevs/iestream.hpp> //Atomic model for inputs
+#include "../atomics/reservoir.hpp"
+#include "../atomics/water_supply_pump.hpp"
+#include "../atomics/city_pump.hpp"
+#include "../atomics/continuous_reservoir.hpp"
+#include "../atomics/continuous_water_supply_pump.hpp"
+#include "../atomics/continuous_city_pump.hpp"
+#include "../atomics/profiled.hpp"
+#include "../atomics/checkpointed.hpp"
+#include "../atomics/binary_input_reader.hpp"
+#include "../atomics/model_parameters.hpp"
+
+//Coupled model headers
+#include "layout.hpp"
+
+//C++ headers
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+/***** Define input port for coupled models *****/
+struct start_city_pumps : public in_port<int>{};
+struct start_supply_pumps : public in_port<int>{};
+struct supply_flow_in : public in_port<volume_type>{};
+struct supply_level : public in_port<float>{};
+/***** Define output ports for coupled models *****/
+struct level : public out_port<float>{};
+struct flow_in : public out_port<volume_type>{};
+
+/****** Input Reader atomic model declaration *******************/
+template<typename T>
+class InputReader_Int : public iestream_input<int,T> {
+public:
+    string file_path;
+    InputReader_Int() = default;
+    InputReader_Int(const char* file_path) : iestream_input<int,T>(file_path), file_path(file_path) {}
+};
+
+/****** Checkpoint of an input reader: its file, the commands left are the ones at or after the checkpoint time *******************/
+template<typename TIME> checkpoint::kind checkpoint_kind(const InputReader_Int<TIME>&) { return checkpoint::input_reader; }
+template<typename TIME> void save_state(checkpoint::writer& w, const InputReader_Int<TIME>& m) {
+    w.put_string(m.file_path);
+}
+// read_checkpoint() turns the reader into a BinaryInputReader on the same file
+template<typename TIME> void load_state(checkpoint::reader& r, InputReader_Int<TIME>& m) {
+    throw runtime_error("Text input readers are restored as BinaryInputReader, see read_checkpoint()");
+}
+
+/****** Input reader of a text input file, or of a compiled one (.bin, see tools/compile_input.cpp) *******************/
+// The models of this file are wrapped for checkpoints only when CHECKPOINT is true, see atomics/checkpointed.hpp
+template<typename TIME, bool CHECKPOINT = false>
+shared_ptr<dynamic::modeling::model> make_input_reader(const string& id, const char * file_path) {
+    size_t length = strlen(file_path);
+    if (length > 4 && strcmp(file_path + length - 4, ".bin") == 0) {
+        return dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, BinaryInputReader)), TIME, const char* >(id, move(file_path));
+    }
+    return dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, InputReader_Int)), TIME, const char* >(id, move(file_path));
+}
+// Input reader of records loaded once (see load_input()) and shared by all the models built from them
+template<typename TIME, bool CHECKPOINT = false>
+shared_ptr<dynamic::modeling::model> make_input_reader(const string& id, shared_ptr<const binary_input_file> file) {
+    return dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, BinaryInputReader)), TIME, shared_ptr<const binary_input_file> >(id, move(file));
+}
+
+/****** Seed of the random engine of the n-th supply pump, derived from the run seed *******************/
+inline unsigned int supply_pump_seed(unsigned int seed, unsigned int pump) {
+    seed_seq seq{seed, pump};
+    unsigned int pump_seed;
+    seq.generate(&pump_seed, &pump_seed + 1);
+    return pump_seed;
+}
+
+/****** Builds the TOP model around its two input readers, the atomic models can be swapped for the continuous ones (same ports), flat with <flat> *******************/
+template<typename TIME, template<typename> class RESERVOIR = Reservoir, template<typename> class SUPPLY_PUMP = WaterSupplyPump, template<typename> class CITY_PUMP = CityPump,
+         bool CHECKPOINT = false>
+shared_ptr<dynamic::modeling::coupled<TIME>> make_city_supply(shared_ptr<dynamic::modeling::model> pumps_input_reader, shared_ptr<dynamic::modeling::model> supply_input_reader,
+                                                              unsigned int seed = 1, double blockage_probability = 0.1, TIME unblock_time = TIME("00:30:00:000"),
+                                                              const model_parameters& parameters = model_parameters(), bool flat = false) {
+    /****** Reservoir atomic model instantiation *******************/
+    shared_ptr<dynamic::modeling::model> reservoir1 = dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, RESERVOIR)), TIME, const model_parameters&>("reservoir1", parameters);
+
+    /****** Water Supply Pumps atomic model instantiation *******************/
+    unsigned int seed_1 = supply_pump_seed(seed, 1);
+    unsigned int seed_2 = supply_pump_seed(seed, 2);
+    double probability_1 = blockage_probability, probability_2 = blockage_probability;
+    TIME unblock_1 = unblock_time, unblock_2 = unblock_time;
+    shared_ptr<dynamic::modeling::model> supply1 = dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, SUPPLY_PUMP)), TIME, unsigned int, double, TIME, const model_parameters&>(
+        "supply1", move(seed_1), move(probability_1), move(unblock_1), parameters);
+    shared_ptr<dynamic::modeling::model> supply2 = dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, SUPPLY_PUMP)), TIME, unsigned int, double, TIME, const model_parameters&>(
+        "supply2", move(seed_2), move(probability_2), move(unblock_2), parameters);
+
+    /****** City Pumps atomic models instantiation *******************/
+    shared_ptr<dynamic::modeling::model> pump1 = dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, CITY_PUMP)), TIME, const model_parameters&>("pump1", parameters);
+    shared_ptr<dynamic::modeling::model> pump2 = dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, CITY_PUMP)), TIME, const model_parameters&>("pump2", parameters);
+
+    /*******TOP COUPLED MODEL: Water Supply (supply pumps), Pump Station (city pumps and reservoir) and the input readers********/
+    model_node<TIME> TOP("TOP", {}, {typeid(level)}, {
+        model_node<TIME>("WaterSupply", {typeid(start_supply_pumps),typeid(supply_level)}, {typeid(flow_in)}, {supply1, supply2}),
+        model_node<TIME>("PumpStation", {typeid(start_city_pumps),typeid(supply_flow_in)}, {typeid(level)}, {pump1, pump2, reservoir1}),
+        supply_input_reader,
+        pumps_input_reader
+    });
+    vector<coupling> couplings;
+    for (const char * supply : {"supply1", "supply2"}) {
+        couplings.push_back(make_coupling<iestream_input_defs<int>::out, start_supply_pumps, WaterSupplyPump_defs::start>("supply_input_reader", supply));
+        couplings.push_back(make_coupling<Reservoir_defs::level, level, supply_level, WaterSupplyPump_defs::level>("reservoir1", supply));
+        couplings.push_back(make_coupling<WaterSupplyPump_defs::flow, flow_in, supply_flow_in, Reservoir_defs::flow_in>(supply, "reservoir1"));
+    }
+    for (const char * pump : {"pump1", "pump2"}) {
+        couplings.push_back(make_coupling<iestream_input_defs<int>::out, start_city_pumps, CityPump_defs::start>("pumps_input_reader", pump));
+        couplings.push_back(make_coupling<CityPump_defs::flow, Reservoir_defs::flow_out>(pump, "reservoir1"));
+        couplings.push_back(make_coupling<Reservoir_defs::level, CityPump_defs::level>("reservoir1", pump));
+    }
+    couplings.push_back(make_coupling<Reservoir_defs::level, level, level>("reservoir1", ""));
+    return build_model(TOP, couplings, flat);
+}
+
+/****** Builds the TOP model reading its input files, text or compiled (.bin) *******************/
+template<typename TIME, template<typename> class RESERVOIR = Reservoir, template<typename> class SUPPLY_PUMP = WaterSupplyPump, template<typename> class CITY_PUMP = CityPump,
+         bool CHECKPOINT = false>
+shared_ptr<dynamic::modeling::coupled<TIME>> make_city_supply(const char * i_input_1, const char * i_input_2, unsigned int seed = 1,
+                                                              double blockage_probability = 0.1, TIME unblock_time = TIME("00:30:00:000"),
+                                                              const model_parameters& parameters = model_parameters(), bool flat = false) {
+    /****** Input Readers atomic model instantiation *******************/
+    shared_ptr<dynamic::modeling::model> pumps_input_reader  = make_input_reader<TIME, CHECKPOINT>("pumps_input_reader" , i_input_1);
+    shared_ptr<dynamic::modeling::model> supply_input_reader = make_input_reader<TIME, CHECKPOINT>("supply_input_reader" , i_input_2);
+    return make_city_supply<TIME, RESERVOIR, SUPPLY_PUMP, CITY_PUMP, CHECKPOINT>(pumps_input_reader, supply_input_reader, seed, blockage_probability, unblock_time, parameters, flat);
+}
+#endif // _CITY_SUPPLY_HPP__
@@ -0,0 +1,120 @@
+/**
+ * Cadmium implementation of CD++ coupled models from City Water Supply
+ *
+ * Static (tuple based) declaration of the same TOP model built by
+ * make_city_supply() in city_supply.hpp. Every submodel needs its own type,
+ * so each atomic instance is declared as a class named after its dynamic id.
+ * Static models are default constructed by the runner, so the input files,
+ * seed and blockages reach them through the type of the model:
+ * city_supply_static<parameters>::TOP, <parameters> being an object with
+ * static storage that is filled before the runner is built.
+**/
+
+#ifndef _CITY_SUPPLY_STATIC_HPP__
+#define _CITY_SUPPLY_STATIC_HPP__
+
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+
+//Coupled model headers (shared port definitions)
+#include "city_supply.hpp"
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+/****** Input files and supply pumps blockages of the model *******************/
+struct city_supply_static_parameters {
+    string       pumps_input;
+    string       supply_input;
+    unsigned int seed = 1;
+    double       blockage_probability = 0.1;
+    string       unblock_time = "00:30:00:000";
+};
+
+template<const city_supply_static_parameters& P>
+struct city_supply_static {
+    /****** Input Readers atomic models *******************/
+    template<typename T>
+    class pumps_input_reader : public PROFILED(InputReader_Int)<T> {
+    public:
+        pumps_input_reader() : PROFILED(InputReader_Int)<T>(P.pumps_input.c_str()) {}
+    };
+    template<typename T>
+    class supply_input_reader : public PROFILED(InputReader_Int)<T> {
+    public:
+        supply_input_reader() : PROFILED(InputReader_Int)<T>(P.supply_input.c_str()) {}
+    };
+
+    /****** Reservoir, Water Supply Pumps and City Pumps atomic models *******************/
+    template<typename T> class reservoir1 : public PROFILED(Reservoir)<T> {};
+    template<typename T> class supply1 : public PROFILED(WaterSupplyPump)<T> {
+    public:
+        supply1() : PROFILED(WaterSupplyPump)<T>(supply_pump_seed(P.seed, 1), P.blockage_probability, T(P.unblock_time.c_str())) {}
+    };
+    template<typename T> class supply2 : public PROFILED(WaterSupplyPump)<T> {
+    public:
+        supply2() : PROFILED(WaterSupplyPump)<T>(supply_pump_seed(P.seed, 2), P.blockage_probability, T(P.unblock_time.c_str())) {}
+    };
+    template<typename T> class pump1 : public PROFILED(CityPump)<T> {};
+    template<typename T> class pump2 : public PROFILED(CityPump)<T> {};
+
+    /*******Water Supply COUPLED MODEL********/
+    using iports_WaterSupply = tuple<start_supply_pumps, supply_level>;
+    using oports_WaterSupply = tuple<flow_in>;
+    using submodels_WaterSupply = modeling::models_tuple<supply1, supply2>;
+    using eics_WaterSupply = tuple<
+        modeling::EIC<start_supply_pumps, supply1, WaterSupplyPump_defs::start>,
+        modeling::EIC<start_supply_pumps, supply2, WaterSupplyPump_defs::start>,
+        modeling::EIC<supply_level, supply1, WaterSupplyPump_defs::level>,
+        modeling::EIC<supply_level, supply2, WaterSupplyPump_defs::level>
+    >;
+    using eocs_WaterSupply = tuple<
+        modeling::EOC<supply1, WaterSupplyPump_defs::flow, flow_in>,
+        modeling::EOC<supply2, WaterSupplyPump_defs::flow, flow_in>
+    >;
+    using ics_WaterSupply = tuple<>;
+    template<typename TIME>
+    using WaterSupply = modeling::pdevs::coupled_model<TIME, iports_WaterSupply, oports_WaterSupply, submodels_WaterSupply, eics_WaterSupply, eocs_WaterSupply, ics_WaterSupply>;
+
+    /*******Pump Station COUPLED MODEL********/
+    using iports_PumpStation = tuple<start_city_pumps, supply_flow_in>;
+    using oports_PumpStation = tuple<level>;
+    using submodels_PumpStation = modeling::models_tuple<pump1, pump2, reservoir1>;
+    using eics_PumpStation = tuple<
+        modeling::EIC<start_city_pumps, pump1, CityPump_defs::start>,
+        modeling::EIC<start_city_pumps, pump2, CityPump_defs::start>,
+        modeling::EIC<supply_flow_in, reservoir1, Reservoir_defs::flow_in>
+    >;
+    using eocs_PumpStation = tuple<
+        modeling::EOC<reservoir1, Reservoir_defs::level, level>
+    >;
+    using ics_PumpStation = tuple<
+        modeling::IC<pump1, CityPump_defs::flow, reservoir1, Reservoir_defs::flow_out>,
+        modeling::IC<pump2, CityPump_defs::flow, reservoir1, Reservoir_defs::flow_out>,
+        modeling::IC<reservoir1, Reservoir_defs::level, pump1, CityPump_defs::level>,
+        modeling::IC<reservoir1, Reservoir_defs::level, pump2, CityPump_defs::level>
+    >;
+    template<typename TIME>
+    using PumpStation = modeling::pdevs::coupled_model<TIME, iports_PumpStation, oports_PumpStation, submodels_PumpStation, eics_PumpStation, eocs_PumpStation, ics_PumpStation>;
+
+    /*******TOP COUPLED MODEL********/
+    using iports_TOP = tuple<>;
+    using oports_TOP = tuple<level>;
+    using submodels_TOP = modeling::models_tuple<WaterSupply, PumpStation, supply_input_reader, pumps_input_reader>;
+    using eics_TOP = tuple<>;
+    using eocs_TOP = tuple<
+        modeling::EOC<PumpStation, level, level>
+    >;
+    using ics_TOP = tuple<
+        modeling::IC<WaterSupply, flow_in, PumpStation, supply_flow_in>,
+        modeling::IC<PumpStation, level, WaterSupply, supply_level>,
+        modeling::IC<supply_input_reader, iestream_input_defs<int>::out, WaterSupply, start_supply_pumps>,
+        modeling::IC<pumps_input_reader, iestream_input_defs<int>::out, PumpStation, start_city_pumps>
+    >;
+    template<typename TIME>
+    using TOP = modeling::pdevs::coupled_model<TIME, iports_TOP, oports_TOP, submodels_TOP, eics_TOP, eocs_TOP, ics_TOP>;
+};
+
+#endif // _CITY_SUPPLY_STATIC_HPP__
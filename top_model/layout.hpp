@@ -0,0 +1,192 @@
+/**
+ * Coupled and flat layouts of a dynamic TOP model from one description
+ *
+ * A model_node is an atomic model, or a coupled model (id and ports) of
+ * nodes, at any depth. A coupling goes from an output port of an atomic
+ * model to an input port of another one, through the ports of the coupled
+ * models it leaves and enters: make_coupling<PORTS...>(from, to) lists all
+ * of them in order. An empty <from> stands for an input port of the top
+ * model, an empty <to> for one of its output ports.
+ *
+ * build_model() makes the coupled models of the description: a coupling
+ * gets an EOC out of every coupled model it leaves, an IC in the one it
+ * crosses and an EIC into every one it enters (shared by the couplings going
+ * the same way). With <flat> the atomic models go straight into the top
+ * model, in the same (depth first) order, and each coupling is one IC (EIC,
+ * EOC) from its first port to its last. Every link of both layouts is made
+ * by make_EIC, make_EOC or make_IC on its two ports, as Cadmium types them.
+**/
+
+#ifndef _LAYOUT_HPP__
+#define _LAYOUT_HPP__
+
+//Cadmium Simulator headers
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+
+//C++ headers
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+template<typename TIME>
+struct model_node {
+    shared_ptr<dynamic::modeling::model> atomic; // Null for a coupled model
+    string                               id;
+    dynamic::modeling::Ports             iports;
+    dynamic::modeling::Ports             oports;
+    vector<model_node>                   models;
+
+    model_node(shared_ptr<dynamic::modeling::model> i_atomic) : atomic(move(i_atomic)), id(atomic->get_id()) {}
+    model_node(string i_id, dynamic::modeling::Ports i_iports, dynamic::modeling::Ports i_oports, vector<model_node> i_models)
+        : id(move(i_id)), iports(move(i_iports)), oports(move(i_oports)), models(move(i_models)) {}
+};
+
+/****** Links between two ports, made for whichever end the layout needs *******************/
+struct port_link {
+    type_index from;
+    type_index to;
+    dynamic::modeling::EIC (*eic)(const string& to);
+    dynamic::modeling::EOC (*eoc)(const string& from);
+    dynamic::modeling::IC  (*ic)(const string& from, const string& to);
+};
+
+template<typename PORT_FROM, typename PORT_TO>
+port_link make_port_link() {
+    return {typeid(PORT_FROM), typeid(PORT_TO),
+            [](const string& to) { return dynamic::translate::make_EIC<PORT_FROM, PORT_TO>(to); },
+            [](const string& from) { return dynamic::translate::make_EOC<PORT_FROM, PORT_TO>(from); },
+            [](const string& from, const string& to) { return dynamic::translate::make_IC<PORT_FROM, PORT_TO>(from, to); }};
+}
+
+struct coupling {
+    string            from;   // Atomic model, empty for an input port of the top model
+    string            to;     // Atomic model, empty for an output port of the top model
+    vector<port_link> steps;  // Between each two ports in a row, one per coupling of the coupled layout
+    port_link         direct; // From the first port to the last, the coupling of the flat layout
+};
+
+template<typename PORTS, size_t... I>
+vector<port_link> make_steps(index_sequence<I...>) {
+    return {make_port_link<tuple_element_t<I, PORTS>, tuple_element_t<I + 1, PORTS>>()...};
+}
+
+template<typename... PORTS>
+coupling make_coupling(const string& from, const string& to) {
+    static_assert(sizeof...(PORTS) >= 2, "A coupling goes from one port to another");
+    using ports = tuple<PORTS...>;
+    return {from, to, make_steps<ports>(make_index_sequence<sizeof...(PORTS) - 1>()),
+            make_port_link<tuple_element_t<0, ports>, tuple_element_t<sizeof...(PORTS) - 1, ports>>()};
+}
+
+template<typename TIME>
+class layout_builder {
+    using node = model_node<TIME>;
+    struct links {
+        dynamic::modeling::EICs eics;
+        dynamic::modeling::EOCs eocs;
+        dynamic::modeling::ICs  ics;
+        set<tuple<char, string, string, type_index, type_index>> added; // Links already made, shared by the couplings going the same way
+    };
+
+    const node&                          top;
+    map<string, vector<const node *>>    parents; // Atomic model id -> coupled models from the top one down to its own
+    map<const node *, links>             coupled_links;
+    dynamic::modeling::Models            atomics; // Depth first
+
+    void visit(const node& n, vector<const node *>& path) {
+        path.push_back(&n);
+        for (const node& m : n.models) {
+            if (!m.atomic) {
+                visit(m, path);
+                continue;
+            }
+            if (!parents.emplace(m.id, path).second) throw runtime_error("Duplicated model id " + m.id);
+            atomics.push_back(m.atomic);
+        }
+        path.pop_back();
+    }
+
+    const vector<const node *>& path_to(const string& id) const {
+        auto it = parents.find(id);
+        if (it == parents.end()) throw runtime_error("Coupling of unknown model " + id);
+        return it->second;
+    }
+
+    void add(const node * n, char kind, const string& from, const string& to, const port_link& step) {
+        links& l = coupled_links[n];
+        if (!l.added.emplace(kind, from, to, step.from, step.to).second) return;
+        if (kind == 'i') l.eics.push_back(step.eic(to));
+        else if (kind == 'o') l.eocs.push_back(step.eoc(from));
+        else l.ics.push_back(step.ic(from, to));
+    }
+
+    // EOCs up to the coupled model holding both ends, an IC in it, EICs down to <to>
+    void add_coupled(const coupling& c) {
+        if (c.from.empty() && c.to.empty()) throw runtime_error("Coupling of " + top.id + " to itself");
+        const vector<const node *> at_top = {&top};
+        const vector<const node *>& up = c.from.empty() ? at_top : path_to(c.from);
+        const vector<const node *>& down = c.to.empty() ? at_top : path_to(c.to);
+        size_t shared = 0;
+        while (shared < up.size() && shared < down.size() && up[shared] == down[shared]) shared++;
+        size_t needed = (up.size() - shared) + 1 + (down.size() - shared);
+        if (c.steps.size() != needed) {
+            throw runtime_error("Coupling from " + (c.from.empty() ? top.id : c.from) + " to " + (c.to.empty() ? top.id : c.to) + " has "
+                                + to_string(c.steps.size() + 1) + " ports, its path needs " + to_string(needed + 1));
+        }
+        size_t step = 0;
+        for (size_t i = up.size(); i-- > shared;) add(up[i], 'o', i + 1 == up.size() ? c.from : up[i + 1]->id, "", c.steps[step++]);
+        const node * across = up[shared - 1];
+        string from = shared < up.size() ? up[shared]->id : c.from;
+        string to = shared < down.size() ? down[shared]->id : c.to;
+        if (c.from.empty()) add(across, 'i', "", to, c.steps[step++]);
+        else if (c.to.empty()) add(across, 'o', from, "", c.steps[step++]);
+        else add(across, 'c', from, to, c.steps[step++]);
+        for (size_t i = shared; i < down.size(); i++) add(down[i], 'i', "", i + 1 == down.size() ? c.to : down[i + 1]->id, c.steps[step++]);
+    }
+
+    shared_ptr<dynamic::modeling::coupled<TIME>> make(const node& n) {
+        dynamic::modeling::Models models;
+        for (const node& m : n.models) models.push_back(m.atomic ? m.atomic : make(m));
+        const links& l = coupled_links[&n];
+        return make_shared<dynamic::modeling::coupled<TIME>>(n.id, models, n.iports, n.oports, l.eics, l.eocs, l.ics);
+    }
+
+public:
+    explicit layout_builder(const node& i_top) : top(i_top) {
+        vector<const node *> path;
+        visit(top, path);
+    }
+
+    shared_ptr<dynamic::modeling::coupled<TIME>> build(const vector<coupling>& couplings, bool flat) {
+        if (!flat) {
+            for (const coupling& c : couplings) add_coupled(c);
+            return make(top);
+        }
+        links& l = coupled_links[&top];
+        for (const coupling& c : couplings) {
+            if (!c.from.empty()) path_to(c.from);
+            if (!c.to.empty()) path_to(c.to);
+            if (c.from.empty()) l.eics.push_back(c.direct.eic(c.to));
+            else if (c.to.empty()) l.eocs.push_back(c.direct.eoc(c.from));
+            else l.ics.push_back(c.direct.ic(c.from, c.to));
+        }
+        return make_shared<dynamic::modeling::coupled<TIME>>(top.id, atomics, top.iports, top.oports, l.eics, l.eocs, l.ics);
+    }
+};
+
+/****** TOP model of the description, its coupled models kept or flattened *******************/
+template<typename TIME>
+shared_ptr<dynamic::modeling::coupled<TIME>> build_model(const model_node<TIME>& top, const vector<coupling>& couplings, bool flat = false) {
+    return layout_builder<TIME>(top).build(couplings, flat);
+}
+#endif // _LAYOUT_HPP__
@@ -8,155 +8,338 @@
 //Time class header
 #include <NDTime.hpp>
 
-//Atomic model headers
-#include <cadmium/basic_model/pdevs/iestream.hpp> //Atomic model for inputs
-#include "../atomics/reservoir.hpp"
-#include "../atomics/water_supply_pump.hpp"
-#include "../atomics/city_pump.hpp"
+//Coupled model and logger headers
+#include "city_supply.hpp"
+#include "network.hpp"
+#include "network_partitions.hpp"
+#include "network_simulator.hpp"
+#include "checkpoint.hpp"
+#include "arguments.hpp"
+#include "../loggers/binary_state_logger.hpp"
+#include "../loggers/delta_state_logger.hpp"
+#include "../loggers/async_filebuf.hpp"
+#include "../loggers/live_metrics.hpp"
+#include "../loggers/run_statistics.hpp"
 
 //C++ headers
 #include <iostream>
 #include <chrono>
 #include <algorithm>
 #include <string>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
 
 
 using namespace std;
 using namespace cadmium;
 using namespace cadmium::basic_models::pdevs;
 
-using TIME = NDTime;
-
-/***** Define input port for coupled models *****/
-struct start_city_pumps : public in_port<int>{};
-struct start_supply_pumps : public in_port<int>{};
-struct supply_flow_in : public in_port<float>{};
-struct supply_level : public in_port<float>{};
-/***** Define output ports for coupled models *****/
-struct level : public out_port<float>{};
-struct flow_in : public out_port<float>{};
-
-/****** Input Reader atomic model declaration *******************/
-template<typename T>
-class InputReader_Int : public iestream_input<int,T> {
-public:
-    InputReader_Int() = default;
-    InputReader_Int(const char* file_path) : iestream_input<int,T>(file_path) {}
-};
+using TIME = time_type;
+
+template<typename LOGGER>
+void run_city_supply(shared_ptr<dynamic::modeling::coupled<TIME>> TOP, const TIME& start, const TIME& until, const string& checkpoint_path) {
+    dynamic::engine::runner<TIME, LOGGER> r(TOP, start);
+    r.run_until(until);
+    if (!checkpoint_path.empty()) save_checkpoint(TOP, until, checkpoint_path);
+}
+
+/****** Builds the TOP model from a network description or the two input files (restored ones with a checkpoint) *******************/
+// The atomic models are wrapped for checkpoints only when the run saves or restores one, see atomics/checkpointed.hpp
+template<bool CHECKPOINT>
+shared_ptr<dynamic::modeling::coupled<TIME>> make_top(const network_description * network, const checkpoint_data * resumed, const char * i_input_1, const char * i_input_2,
+                                                      bool continuous, unsigned int seed, double blockage_probability, const TIME& unblock_time,
+                                                      const model_parameters& parameters, bool flat) {
+    if (network && continuous) {
+        return make_network_model<TIME, ContinuousReservoir, ContinuousWaterSupplyPump, ContinuousCityPump, CHECKPOINT>(*network, seed, blockage_probability, unblock_time, parameters, flat);
+    }
+    if (network) return make_network_model<TIME, Reservoir, WaterSupplyPump, CityPump, CHECKPOINT>(*network, seed, blockage_probability, unblock_time, parameters, flat);
+    shared_ptr<dynamic::modeling::model> pumps_input_reader = resumed ? make_input_reader<TIME, CHECKPOINT>("pumps_input_reader", resumed->input("pumps_input_reader"))
+                                                                      : make_input_reader<TIME, CHECKPOINT>("pumps_input_reader", i_input_1);
+    shared_ptr<dynamic::modeling::model> supply_input_reader = resumed ? make_input_reader<TIME, CHECKPOINT>("supply_input_reader", resumed->input("supply_input_reader"))
+                                                                       : make_input_reader<TIME, CHECKPOINT>("supply_input_reader", i_input_2);
+    if (continuous) {
+        return make_city_supply<TIME, ContinuousReservoir, ContinuousWaterSupplyPump, ContinuousCityPump, CHECKPOINT>(pumps_input_reader, supply_input_reader, seed, blockage_probability,
+                                                                                                                     unblock_time, parameters, flat);
+    }
+    return make_city_supply<TIME, Reservoir, WaterSupplyPump, CityPump, CHECKPOINT>(pumps_input_reader, supply_input_reader, seed, blockage_probability, unblock_time, parameters, flat);
+}
+
+template<typename LOGGER>
+void run_network_simulator(const network_description& description, bool continuous, unsigned int seed, double blockage_probability, const TIME& unblock_time,
+                           const model_parameters& parameters, const TIME& until) {
+    if (continuous) {
+        network_simulator<TIME, LOGGER, ContinuousReservoir, ContinuousWaterSupplyPump, ContinuousCityPump> simulator(description, seed, blockage_probability, unblock_time, parameters);
+        simulator.run_until(until);
+    } else {
+        network_simulator<TIME, LOGGER> simulator(description, seed, blockage_probability, unblock_time, parameters);
+        simulator.run_until(until);
+    }
+}
 
 int main(int argc, char ** argv) {
 
-    if (argc < 2) {
+    /****** Options (--name or --name=value) can be given anywhere, the rest are positional arguments *******************/
+    const set<string> known_options = {"--binary-state", "--delta-state", "--async-log", "--network", "--continuous", "--until", "--checkpoint", "--restore",
+                                     "--live-file", "--live-socket", "--live-interval", "--statistics", "--no-log", "--flat", "--threads", "--event-queue",
+                                     "--min-level", "--max-level", "--supply-flow", "--city-flow", "--surface", "--height"};
+    map<string, string> options;
+    vector<char *> args = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        size_t equal = option.find('=');
+        if (strncmp(argv[i], "--", 2) != 0) {
+            args.push_back(argv[i]);
+        } else if (known_options.count(option.substr(0, equal))) {
+            options[option.substr(0, equal)] = equal == string::npos ? "" : option.substr(equal + 1);
+        } else {
+            cout << "Unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+    argc = args.size();
+    argv = args.data();
+    if (options.count("--binary-state") && options.count("--delta-state")) {
+        cout << "--binary-state and --delta-state cannot be combined" << endl;
+        return 1;
+    }
+    if (options.count("--no-log") && (options.count("--binary-state") || options.count("--delta-state"))) {
+        cout << "--no-log cannot be combined with --binary-state or --delta-state" << endl;
+        return 1;
+    }
+    // The partitions of a parallel run only keep their statistics
+    if (options.count("--threads") && (!options.count("--network") || !options.count("--no-log") || options.count("--checkpoint") || options.count("--restore")
+                                       || options.count("--live-file") || options.count("--live-socket"))) {
+        cout << "--threads needs --network and --no-log, and cannot be combined with --checkpoint, --restore or the live metrics" << endl;
+        return 1;
+    }
+    // The event-queue simulator only logs the states that change, and has no TOP model to checkpoint
+    if (options.count("--event-queue") && (!options.count("--network") || !(options.count("--no-log") || options.count("--delta-state"))
+                                           || options.count("--threads") || options.count("--checkpoint") || options.count("--restore"))) {
+        cout << "--event-queue needs --network with --no-log or --delta-state, and cannot be combined with --threads, --checkpoint or --restore" << endl;
+        return 1;
+    }
+
+    // With --network=<file> the model and its input files come from a network description, with --restore=<file> the input files come from the checkpoint
+    bool network = options.count("--network");
+    bool restore = options.count("--restore");
+    int first_parameter = network || restore ? 1 : 3;
+    if (argc < first_parameter) {
         cout << "Program used with wrong parameters. The program must be invoked as follow:";
-        cout << argv[0] << " path to the input file " << endl;
-        return 1; 
-    }
-    /****** Input Readers atomic model instantiation *******************/
-    string input_1 = argv[1];
-    const char * i_input_1 = input_1.c_str();
-    shared_ptr<dynamic::modeling::model> pumps_input_reader  = dynamic::translate::make_dynamic_atomic_model<InputReader_Int, TIME, const char* >("pumps_input_reader" , move(i_input_1));
-
-    string input_2 = argv[2];
-    const char * i_input_2 = input_2.c_str();
-    shared_ptr<dynamic::modeling::model> supply_input_reader = dynamic::translate::make_dynamic_atomic_model<InputReader_Int, TIME, const char* >("supply_input_reader" , move(i_input_2));
-
-    /****** Reservoir atomic model instantiation *******************/
-    shared_ptr<dynamic::modeling::model> reservoir1 = dynamic::translate::make_dynamic_atomic_model<Reservoir, TIME>("reservoir1");
-
-    /****** Water Supply Pumps atomic model instantiation *******************/
-    shared_ptr<dynamic::modeling::model> supply1 = dynamic::translate::make_dynamic_atomic_model<WaterSupplyPump, TIME>("supply1");
-    shared_ptr<dynamic::modeling::model> supply2 = dynamic::translate::make_dynamic_atomic_model<WaterSupplyPump, TIME>("supply2");
-
-    /****** City Pumps atomic models instantiation *******************/
-    shared_ptr<dynamic::modeling::model> pump1 = dynamic::translate::make_dynamic_atomic_model<CityPump, TIME>("pump1");
-    shared_ptr<dynamic::modeling::model> pump2 = dynamic::translate::make_dynamic_atomic_model<CityPump, TIME>("pump2");
-
-    /*******Water Supply COUPLED MODEL********/
-    dynamic::modeling::Ports iports_Supply = {typeid(start_supply_pumps),typeid(supply_level)};
-    dynamic::modeling::Ports oports_Supply = {typeid(flow_in)};
-    dynamic::modeling::Models submodels_Supply = {supply1, supply2};
-    dynamic::modeling::EICs eics_Supply = {
-        dynamic::translate::make_EIC<start_supply_pumps, WaterSupplyPump_defs::start>("supply1"),
-        dynamic::translate::make_EIC<start_supply_pumps, WaterSupplyPump_defs::start>("supply2"),
-        dynamic::translate::make_EIC<supply_level, WaterSupplyPump_defs::level>("supply1"),
-        dynamic::translate::make_EIC<supply_level, WaterSupplyPump_defs::level>("supply2"),
-    };
-    dynamic::modeling::EOCs eocs_Supply = {
-        dynamic::translate::make_EOC<WaterSupplyPump_defs::flow,flow_in>("supply1"),
-        dynamic::translate::make_EOC<WaterSupplyPump_defs::flow,flow_in>("supply2")
-    };
-    dynamic::modeling::ICs ics_Supply = {};
-    shared_ptr<dynamic::modeling::coupled<TIME>> WaterSupply;
-    WaterSupply = make_shared<dynamic::modeling::coupled<TIME>>(
-        "WaterSupply", submodels_Supply, iports_Supply, oports_Supply, eics_Supply, eocs_Supply, ics_Supply 
-    );
-
-    /*******Pump Station COUPLED MODEL********/
-    dynamic::modeling::Ports iports_PumpStation = {typeid(start_city_pumps),typeid(supply_flow_in)};
-    dynamic::modeling::Ports oports_PumpStation = {typeid(level)};
-    dynamic::modeling::Models submodels_PumpStation = {pump1, pump2, reservoir1};
-    dynamic::modeling::EICs eics_PumpStation = {
-        cadmium::dynamic::translate::make_EIC<start_city_pumps, CityPump_defs::start>("pump1"),
-        cadmium::dynamic::translate::make_EIC<start_city_pumps, CityPump_defs::start>("pump2"),
-        cadmium::dynamic::translate::make_EIC<supply_flow_in, Reservoir_defs::flow_in>("reservoir1"),
-    };
-    dynamic::modeling::EOCs eocs_PumpStation = {
-        dynamic::translate::make_EOC<Reservoir_defs::level,level>("reservoir1")
-    };
-    dynamic::modeling::ICs ics_PumpStation = {
-        dynamic::translate::make_IC<CityPump_defs::flow, Reservoir_defs::flow_out>("pump1","reservoir1"),
-        dynamic::translate::make_IC<CityPump_defs::flow, Reservoir_defs::flow_out>("pump2","reservoir1"),
-        dynamic::translate::make_IC<Reservoir_defs::level, CityPump_defs::level>("reservoir1", "pump1"),
-        dynamic::translate::make_IC<Reservoir_defs::level, CityPump_defs::level>("reservoir1", "pump2"),
-    };
-    shared_ptr<dynamic::modeling::coupled<TIME>> PumpStation;
-    PumpStation = make_shared<dynamic::modeling::coupled<TIME>>(
-        "PumpStation", submodels_PumpStation, iports_PumpStation, oports_PumpStation, eics_PumpStation, eocs_PumpStation, ics_PumpStation 
-    );
+        cout << argv[0] << " path to the city pumps input file, path to the supply pumps input file [, seed [, blockage probability [, unblock time]]] [--binary-state | --delta-state] [--async-log] [--continuous] [--until=<time>] [--checkpoint=<file>] [--live-file=<file> | --live-socket=<path>] [--live-interval=<ms>] [--statistics=<file>] [--no-log] [--flat] [--min-level=<m>] [--max-level=<m>] [--supply-flow=<m^3/s>] [--city-flow=<m^3/s>] [--surface=<m^2>] [--height=<m>] " << endl;
+        cout << "or: " << argv[0] << " --network=<network description> [seed [, blockage probability [, unblock time]]] [--threads=<n> | --event-queue] [options] " << endl;
+        cout << "or: " << argv[0] << " --restore=<checkpoint> [--network=<network description>] [seed] [options] " << endl;
+        return 1;
+    }
 
+    /****** Supply pumps random blockages and end of the run, malformed numbers and times are rejected *******************/
+    unsigned int seed = 1;
+    double blockage_probability = 0.1;
+    TIME unblock_time, until;
+    try {
+        if (argc > first_parameter) seed = parse_unsigned(argv[first_parameter], "seed");
+        if (argc > first_parameter + 1) blockage_probability = parse_double(argv[first_parameter + 1], "blockage probability");
+        check_blockage_probability(blockage_probability);
+        unblock_time = argc > first_parameter + 2 ? TIME(argv[first_parameter + 2]) : TIME("00:30:00:000");
+        until = TIME(options.count("--until") ? options["--until"] : "24:00:00:000");
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    /****** Levels, flows and reservoir size, the defaults are the values of the original model *******************/
+    model_parameters parameters;
+    try {
+        for (const auto& field : model_parameters::fields()) {
+            string option = model_parameters::option(field.first);
+            if (options.count(option)) parameters.*field.second = parse_double(options[option], option);
+        }
+        parameters.check();
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    /****** Checkpoint to resume from, the model must be built with the same options as the one saved *******************/
+    checkpoint_data resumed;
+    try {
+        if (restore) resumed = read_checkpoint<TIME>(options["--restore"]);
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
 
     /*******TOP COUPLED MODEL********/
-    dynamic::modeling::Ports iports_TOP = {};
-    dynamic::modeling::Ports oports_TOP = {typeid(level)};
-    dynamic::modeling::Models submodels_TOP = {WaterSupply, PumpStation, supply_input_reader, pumps_input_reader};
-    dynamic::modeling::EICs eics_TOP = {};
-    dynamic::modeling::EOCs eocs_TOP = {
-        dynamic::translate::make_EOC<level,level>("PumpStation")
-    };
-    dynamic::modeling::ICs ics_TOP = {
-        dynamic::translate::make_IC<flow_in, supply_flow_in>("WaterSupply","PumpStation"),
-        dynamic::translate::make_IC<level, supply_level>("PumpStation", "WaterSupply"),
-        dynamic::translate::make_IC<iestream_input_defs<int>::out, start_supply_pumps>("supply_input_reader","WaterSupply"),
-        dynamic::translate::make_IC<iestream_input_defs<int>::out, start_city_pumps>("pumps_input_reader","PumpStation"),
-    };
+    // With --continuous the pumps send flow rate changes and the reservoir integrates the level between threshold crossings
+    bool continuous = options.count("--continuous");
+    // With --flat the atomic models are coupled directly in TOP, messages skip the intermediate coupled models
+    bool flat = options.count("--flat");
+    // With --threads=<n> the network is split in n partitions of whole stations run concurrently, see network_partitions.hpp
+    unsigned int threads = 0;
+    try {
+        if (options.count("--threads")) threads = parse_unsigned(options["--threads"], "--threads", 1);
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+    // With --event-queue the network runs on network_simulator, which keeps the next events of the models in a heap instead of the runner
+    bool event_queue = options.count("--event-queue");
+    // Only runs that save or restore a checkpoint build the models wrapped for it
+    bool checkpoints = options.count("--checkpoint") || restore;
     shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> TOP;
-    TOP = make_shared<dynamic::modeling::coupled<TIME>>(
-        "TOP", submodels_TOP, iports_TOP, oports_TOP, eics_TOP, eocs_TOP, ics_TOP 
-    );
+    network_description description;
+    try {
+        if (network) {
+            description = read_network(options["--network"]);
+            if (restore) {
+                for (network_description::input& input : description.inputs) input.loaded = resumed.input(input.id);
+            }
+        }
+        /****** Input Readers files, text or compiled (.bin) *******************/
+        const network_description * from_network = network ? &description : nullptr;
+        const checkpoint_data * from_checkpoint = restore ? &resumed : nullptr;
+        const char * i_input_1 = network || restore ? nullptr : argv[1];
+        const char * i_input_2 = network || restore ? nullptr : argv[2];
+        // With --threads each partition gets its own TOP model, built by run_partitions, and --event-queue needs none
+        if (checkpoints && !threads && !event_queue) {
+            TOP = make_top<true>(from_network, from_checkpoint, i_input_1, i_input_2, continuous, seed, blockage_probability, unblock_time, parameters, flat);
+        } else if (!threads && !event_queue) {
+            TOP = make_top<false>(from_network, from_checkpoint, i_input_1, i_input_2, continuous, seed, blockage_probability, unblock_time, parameters, flat);
+        }
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    // A seed given with --restore gives the supply pumps new random engines, to branch scenarios from the checkpoint
+    TIME start("00:00:00:000");
+    if (restore) {
+        try {
+            restore_checkpoint(TOP, resumed, argc > first_parameter, seed);
+        } catch (const exception& e) {
+            cout << e.what() << endl;
+            return 1;
+        }
+        start = resumed.start_time<TIME>();
+    }
 
     /*************** Loggers *******************/
-    static ofstream out_messages("../simulation_results/City_Supply_output_messages.txt");
+    static ofstream out_messages;
     struct oss_sink_messages{
-        static ostream& sink(){          
+        static ostream& sink(){
             return out_messages;
         }
     };
-    static ofstream out_state("../simulation_results/City_Supply_output_state.txt");
+    static ofstream out_state;
     struct oss_sink_state{
-        static ostream& sink(){          
+        static ostream& sink(){
             return out_state;
         }
     };
-    
+
     using state=logger::logger<logger::logger_state, dynamic::logger::formatter<TIME>, oss_sink_state>;
     using log_messages=logger::logger<logger::logger_messages, dynamic::logger::formatter<TIME>, oss_sink_messages>;
     using global_time_mes=logger::logger<logger::logger_global_time, dynamic::logger::formatter<TIME>, oss_sink_messages>;
     using global_time_sta=logger::logger<logger::logger_global_time, dynamic::logger::formatter<TIME>, oss_sink_state>;
 
-    using logger_top=logger::multilogger<state, log_messages, global_time_mes, global_time_sta>;
+    // Live metrics, does nothing unless --live-file or --live-socket is given
+    using live=live_metrics<TIME>;
+
+    // Summary statistics, does nothing unless --statistics is given
+    using stats=run_statistics<TIME>;
+
+    using logger_top=logger::multilogger<state, log_messages, global_time_mes, global_time_sta, live, stats>;
+
+    // Binary state log, convert it back to text with bin/STATE_LOG_TO_TEXT
+    using state_bin=binary_state_logger<TIME, oss_sink_state>;
+    using logger_top_bin=logger::multilogger<state_bin, log_messages, global_time_mes, live, stats>;
 
-    /************** Runner call ************************/ 
-    dynamic::engine::runner<NDTime, logger_top> r(TOP, {0});
-    r.run_until(NDTime("24:00:00:000"));
+    // Text state log with only the states that changed
+    using state_delta=delta_state_logger<TIME, oss_sink_state>;
+    using logger_top_delta=logger::multilogger<state_delta, log_messages, global_time_mes, live, stats>;
+
+    // Same with the quiescence lines of the event-queue simulator ("Quiescent from <time> until <time>") in the state log
+    using info_sta=logger::logger<logger::logger_info, dynamic::logger::formatter<TIME>, oss_sink_state>;
+    using logger_top_queue=logger::multilogger<state_delta, info_sta, log_messages, global_time_mes, live, stats>;
+
+    // No log files, for batch runs that only need --statistics or the live metrics
+    using logger_top_none=logger::multilogger<live, stats>;
+
+    int live_interval = 250;
+    try {
+        if (options.count("--live-interval")) live_interval = parse_unsigned(options["--live-interval"], "--live-interval", 1, INT_MAX);
+        if (options.count("--live-file")) live::open_file(options["--live-file"], live_interval);
+        else if (options.count("--live-socket")) live::open_socket(options["--live-socket"], live_interval);
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+    if (options.count("--statistics")) stats::reset(continuous);
+
+    /****** Log files, --async-log writes them from a background thread *******************/
+    static async_filebuf async_messages, async_state;
+    auto open_log = [&](ofstream& os, async_filebuf& buffer, const char * path, ios::openmode mode) {
+        if (options.count("--async-log")) open_async(os, buffer, path, mode);
+        else os.open(path, mode);
+    };
+    if (!options.count("--no-log")) open_log(out_messages, async_messages, "../simulation_results/City_Supply_output_messages.txt", ios::out);
+
+    /************** Runner call ************************/
+    string checkpoint_path = options.count("--checkpoint") ? options["--checkpoint"] : "";
+    if (threads) {
+        try {
+            vector<network_description> partitions = partition_network(description, threads);
+            stats::data_type merged = continuous
+                ? run_partitions<TIME, ContinuousReservoir, ContinuousWaterSupplyPump, ContinuousCityPump>(partitions, threads, until, true, seed, blockage_probability, unblock_time, parameters, flat)
+                : run_partitions<TIME>(partitions, threads, until, false, seed, blockage_probability, unblock_time, parameters, flat);
+            if (options.count("--statistics")) stats::data = move(merged);
+        } catch (const exception& e) {
+            cout << e.what() << endl;
+            return 1;
+        }
+    } else if (event_queue) {
+        try {
+            if (options.count("--no-log")) {
+                run_network_simulator<logger_top_none>(description, continuous, seed, blockage_probability, unblock_time, parameters, until);
+            } else {
+                open_log(out_state, async_state, "../simulation_results/City_Supply_output_state_delta.txt", ios::out);
+                run_network_simulator<logger_top_queue>(description, continuous, seed, blockage_probability, unblock_time, parameters, until);
+            }
+        } catch (const exception& e) {
+            cout << e.what() << endl;
+            return 1;
+        }
+    } else if (options.count("--no-log")) {
+        run_city_supply<logger_top_none>(TOP, start, until, checkpoint_path);
+    } else if (options.count("--binary-state")) {
+        open_log(out_state, async_state, "../simulation_results/City_Supply_output_state.bin", ios::out | ios::binary);
+        state_bin::watch(TOP);
+        run_city_supply<logger_top_bin>(TOP, start, until, checkpoint_path);
+        state_bin::finish();
+    } else if (options.count("--delta-state")) {
+        open_log(out_state, async_state, "../simulation_results/City_Supply_output_state_delta.txt", ios::out);
+        run_city_supply<logger_top_delta>(TOP, start, until, checkpoint_path);
+    } else {
+        open_log(out_state, async_state, "../simulation_results/City_Supply_output_state.txt", ios::out);
+        run_city_supply<logger_top>(TOP, start, until, checkpoint_path);
+    }
+    live::finish();
+    if (options.count("--statistics")) {
+        stats::finish(until);
+        try {
+            stats::write_summary(options["--statistics"]);
+        } catch (const exception& e) {
+            cout << e.what() << endl;
+            return 1;
+        }
+    }
+    async_messages.close();
+    async_state.close();
+#ifdef PROFILE_MODELS
+    model_profile::report(cout);
+    model_profile::write_csv("../simulation_results/City_Supply_profile.csv");
+#endif
     return 0;
-}
\ No newline at end of file
+}
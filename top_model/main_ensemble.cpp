@@ -0,0 +1,104 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model and logger headers
+#include "city_supply.hpp"
+#include "arguments.hpp"
+#include "../loggers/run_statistics.hpp"
+
+//C++ headers
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+using TIME = time_type;
+
+struct replication_result {
+    unsigned int seed;
+    float  min_level;
+    double wait_minutes;
+    double blockage_minutes;
+};
+
+void print_summary(const string& name, const vector<replication_result>& results, double replication_result::* field) {
+    double sum = 0, lo = numeric_limits<double>::infinity(), hi = -numeric_limits<double>::infinity();
+    for (const replication_result& res : results) {
+        sum += res.*field;
+        lo = min(lo, res.*field);
+        hi = max(hi, res.*field);
+    }
+    cout << name << ": mean " << sum / results.size() << " min " << lo << " max " << hi << endl;
+}
+
+int main(int argc, char ** argv) {
+
+    if (argc < 4) {
+        cout << "Program used with wrong parameters. The program must be invoked as follow:";
+        cout << argv[0] << " path to the city pumps input file, path to the supply pumps input file, number of replications [, threads [, seed]] " << endl;
+        return 1;
+    }
+    string input_1 = argv[1];
+    string input_2 = argv[2];
+    int replications = 1;
+    unsigned int threads = max(1u, thread::hardware_concurrency()), seed = 1;
+    try {
+        replications = parse_unsigned(argv[3], "number of replications", 1, INT_MAX);
+        if (argc > 4) threads = parse_unsigned(argv[4], "threads", 1);
+        if (argc > 5) seed = parse_unsigned(argv[5], "seed");
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+    TIME until("24:00:00:000");
+
+    /************** Replications, each with its own seed and logger data ************************/
+    vector<replication_result> results(replications);
+    atomic<int> next_replication(0);
+    auto worker = [&]() {
+        int i;
+        while ((i = next_replication++) < replications) {
+            run_statistics<TIME>::reset();
+            shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_city_supply<TIME>(input_1.c_str(), input_2.c_str(), seed + i);
+            dynamic::engine::runner<TIME, run_statistics<TIME>> r(TOP, {0});
+            r.run_until(until);
+            run_statistics<TIME>::finish(until);
+            results[i] = {seed + i, run_statistics<TIME>::data.min_level,
+                          run_statistics<TIME>::data.wait_seconds / 60.0,
+                          run_statistics<TIME>::data.blockage_seconds / 60.0};
+        }
+    };
+    vector<thread> pool;
+    for (unsigned int t = 0; t < min(threads, (unsigned int) replications); t++) pool.emplace_back(worker);
+    for (thread& t : pool) t.join();
+
+    /************** One line per replication and a summary ************************/
+    ofstream out_results("../simulation_results/City_Supply_ensemble.csv");
+    out_results << "seed,min_level,wait_minutes,blockage_minutes" << endl;
+    for (const replication_result& res : results) {
+        out_results << res.seed << "," << res.min_level << "," << res.wait_minutes << "," << res.blockage_minutes << endl;
+    }
+    float min_level = numeric_limits<float>::infinity();
+    for (const replication_result& res : results) min_level = min(min_level, res.min_level);
+    cout << replications << " replications of 24h on " << pool.size() << " threads" << endl;
+    cout << "min reservoir level: " << min_level << endl;
+    print_summary("wait minutes (supply pumps)", results, &replication_result::wait_minutes);
+    print_summary("blockage minutes (supply pumps)", results, &replication_result::blockage_minutes);
+    return 0;
+}
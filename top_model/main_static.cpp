@@ -0,0 +1,142 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model and logger headers
+#include "city_supply_static.hpp"
+#include "arguments.hpp"
+#include "../loggers/binary_state_logger.hpp"
+#include "../loggers/delta_state_logger.hpp"
+#include "../loggers/async_filebuf.hpp"
+
+//C++ headers
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+using TIME = time_type;
+
+// Input files and blockages of the run, given to the model through its type
+city_supply_static_parameters run_parameters;
+
+template<typename LOGGER>
+void run_city_supply(const TIME& until) {
+    engine::runner<TIME, city_supply_static<run_parameters>::TOP, LOGGER> r(TIME("00:00:00:000"));
+    r.run_until(until);
+}
+
+int main(int argc, char ** argv) {
+
+    /****** Options (--name) can be given anywhere, the rest are positional arguments *******************/
+    const set<string> known_options = {"--binary-state", "--delta-state", "--async-log"};
+    set<string> options;
+    vector<char *> args = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            args.push_back(argv[i]);
+        } else if (known_options.count(argv[i])) {
+            options.insert(argv[i]);
+        } else {
+            cout << "Unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+    argc = args.size();
+    argv = args.data();
+    if (options.count("--binary-state") && options.count("--delta-state")) {
+        cout << "--binary-state and --delta-state cannot be combined" << endl;
+        return 1;
+    }
+
+    if (argc < 3) {
+        cout << "Program used with wrong parameters. The program must be invoked as follow:";
+        cout << argv[0] << " path to the city pumps input file, path to the supply pumps input file [, seed [, blockage probability [, unblock time]]] [--binary-state | --delta-state] [--async-log] " << endl;
+        return 1;
+    }
+    /****** Input Readers files *******************/
+    run_parameters.pumps_input = argv[1];
+    run_parameters.supply_input = argv[2];
+
+    /****** Supply pumps random blockages, malformed values are rejected *******************/
+    if (argc > 5) run_parameters.unblock_time = argv[5];
+    try {
+        if (argc > 3) run_parameters.seed = parse_unsigned(argv[3], "seed");
+        if (argc > 4) run_parameters.blockage_probability = parse_double(argv[4], "blockage probability");
+        check_blockage_probability(run_parameters.blockage_probability);
+        TIME(run_parameters.unblock_time.c_str());
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    /*************** Loggers *******************/
+    static ofstream out_messages;
+    struct oss_sink_messages{
+        static ostream& sink(){
+            return out_messages;
+        }
+    };
+    static ofstream out_state;
+    struct oss_sink_state{
+        static ostream& sink(){
+            return out_state;
+        }
+    };
+
+    using state=logger::logger<logger::logger_state, logger::verbatim_formatter, oss_sink_state>;
+    using log_messages=logger::logger<logger::logger_messages, logger::verbatim_formatter, oss_sink_messages>;
+    using global_time_mes=logger::logger<logger::logger_global_time, logger::verbatim_formatter, oss_sink_messages>;
+    using global_time_sta=logger::logger<logger::logger_global_time, logger::verbatim_formatter, oss_sink_state>;
+
+    using logger_top=logger::multilogger<state, log_messages, global_time_mes, global_time_sta>;
+
+    // Binary state log, the static runner hands over typed states so nothing is formatted
+    using state_bin=binary_state_logger<TIME, oss_sink_state>;
+    using logger_top_bin=logger::multilogger<state_bin, log_messages, global_time_mes>;
+
+    // Text state log with only the states that changed
+    using state_delta=delta_state_logger<TIME, oss_sink_state>;
+    using logger_top_delta=logger::multilogger<state_delta, log_messages, global_time_mes>;
+
+    /****** Log files, --async-log writes them from a background thread *******************/
+    static async_filebuf async_messages, async_state;
+    auto open_log = [&](ofstream& os, async_filebuf& buffer, const char * path, ios::openmode mode) {
+        if (options.count("--async-log")) open_async(os, buffer, path, mode);
+        else os.open(path, mode);
+    };
+    open_log(out_messages, async_messages, "../simulation_results/City_Supply_static_output_messages.txt", ios::out);
+
+    /************** Runner call ************************/
+    TIME until("24:00:00:000");
+    if (options.count("--binary-state")) {
+        open_log(out_state, async_state, "../simulation_results/City_Supply_static_output_state.bin", ios::out | ios::binary);
+        run_city_supply<logger_top_bin>(until);
+        state_bin::finish();
+    } else if (options.count("--delta-state")) {
+        open_log(out_state, async_state, "../simulation_results/City_Supply_static_output_state_delta.txt", ios::out);
+        run_city_supply<logger_top_delta>(until);
+    } else {
+        open_log(out_state, async_state, "../simulation_results/City_Supply_static_output_state.txt", ios::out);
+        run_city_supply<logger_top>(until);
+    }
+    async_messages.close();
+    async_state.close();
+#ifdef PROFILE_MODELS
+    model_profile::report(cout);
+    model_profile::write_csv("../simulation_results/City_Supply_static_profile.csv");
+#endif
+    return 0;
+}
@@ -0,0 +1,240 @@
+//Cadmium Simulator headers
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Time class header
+#include <NDTime.hpp>
+
+//Coupled model and logger headers
+#include "city_supply.hpp"
+#include "arguments.hpp"
+#include "../loggers/run_statistics.hpp"
+
+//C++ headers
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+using TIME = time_type;
+
+// Values of one parameter: a single value, or "from:to[:count]" (count only used by the grid, default 2)
+struct parameter_range {
+    float from, to;
+    int count;
+};
+
+parameter_range parse_range(const string& text) {
+    parameter_range range;
+    range.count = 1;
+    int fields = sscanf(text.c_str(), "%f:%f:%d", &range.from, &range.to, &range.count);
+    if (fields < 1 || range.count < 1) throw invalid_argument("Cannot parse range " + text);
+    if (fields == 1) range.to = range.from;
+    if (fields == 2) range.count = 2;
+    return range;
+}
+
+struct sweep_result {
+    float  min_level;
+    float  max_level;
+    double mean_level;
+    double supply_volume;
+    double city_volume;
+    double wait_minutes;
+    double blockage_minutes;
+};
+
+template<template<typename> class RESERVOIR, template<typename> class SUPPLY_PUMP, template<typename> class CITY_PUMP>
+sweep_result run_set(shared_ptr<const binary_input_file> pumps_input, shared_ptr<const binary_input_file> supply_input, unsigned int seed,
+                     double blockage_probability, const model_parameters& parameters, const TIME& until, bool continuous) {
+    run_statistics<TIME>::reset(continuous);
+    shared_ptr<dynamic::modeling::coupled<TIME>> TOP = make_city_supply<TIME, RESERVOIR, SUPPLY_PUMP, CITY_PUMP>(
+        make_input_reader<TIME>("pumps_input_reader", pumps_input), make_input_reader<TIME>("supply_input_reader", supply_input),
+        seed, blockage_probability, TIME("00:30:00:000"), parameters);
+    dynamic::engine::runner<TIME, run_statistics<TIME>> r(TOP, {0});
+    r.run_until(until);
+    run_statistics<TIME>::finish(until);
+
+    const auto& data = run_statistics<TIME>::data;
+    sweep_result result = {numeric_limits<float>::infinity(), -numeric_limits<float>::infinity(), 0,
+                           run_statistics<TIME>::volume(true), run_statistics<TIME>::volume(false),
+                           data.wait_seconds / 60.0, data.blockage_seconds / 60.0};
+    for (const auto& reservoir : data.reservoirs) {
+        result.min_level = min(result.min_level, reservoir.second.min_level);
+        result.max_level = max(result.max_level, reservoir.second.max_level);
+        result.mean_level += run_statistics<TIME>::mean_level(reservoir.second) / data.reservoirs.size();
+    }
+    return result;
+}
+
+int main(int argc, char ** argv) {
+
+    /****** Options (--name=value) can be given anywhere, the rest are positional arguments *******************/
+    map<string, string> options;
+    vector<char *> args = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            args.push_back(argv[i]);
+            continue;
+        }
+        string option = argv[i];
+        size_t equal = option.find('=');
+        options[option.substr(0, equal)] = equal == string::npos ? "" : option.substr(equal + 1);
+    }
+    if (args.size() < 3) {
+        cout << "Program used with wrong parameters. The program must be invoked as follow:";
+        cout << argv[0] << " path to the city pumps input file, path to the supply pumps input file [--<parameter>=<value> | --<parameter>=<from>:<to>[:<count>]]... "
+             << "[--lhs=<sets>] [--replications=<n>] [--threads=<n>] [--seed=<n>] [--blockage-probability=<p>] [--until=<time>] [--continuous] [--output=<file>] " << endl;
+        cout << "parameters:";
+        for (const auto& field : model_parameters::fields()) cout << " " << model_parameters::option(field.first);
+        cout << endl;
+        return 1;
+    }
+    auto option = [&](const string& name, const string& fallback) {
+        auto it = options.find(name);
+        if (it == options.end()) return fallback;
+        string value = it->second;
+        options.erase(it);
+        return value;
+    };
+    int lhs_sets = 0, replications = 1;
+    unsigned int threads = 1, seed = 1;
+    double blockage_probability = 0.1;
+    TIME until;
+    try {
+        lhs_sets = parse_unsigned(option("--lhs", "0"), "--lhs", 0, INT_MAX);
+        replications = parse_unsigned(option("--replications", "1"), "--replications", 1, INT_MAX);
+        threads = parse_unsigned(option("--threads", to_string(max(1u, thread::hardware_concurrency()))), "--threads", 1);
+        seed = parse_unsigned(option("--seed", "1"), "--seed");
+        blockage_probability = parse_double(option("--blockage-probability", "0.1"), "--blockage-probability");
+        check_blockage_probability(blockage_probability);
+        until = TIME(option("--until", "24:00:00:000"));
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+    bool continuous = options.count("--continuous");
+    options.erase("--continuous");
+    string output = option("--output", "../simulation_results/City_Supply_sweep.csv");
+
+    /****** Range of each parameter, the others keep their default value *******************/
+    vector<parameter_range> ranges;
+    try {
+        for (const auto& field : model_parameters::fields()) {
+            model_parameters defaults;
+            ranges.push_back(parse_range(option(model_parameters::option(field.first), to_string(defaults.*field.second))));
+        }
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+    if (!options.empty()) {
+        cout << "Unknown option " << options.begin()->first << endl;
+        return 1;
+    }
+
+    /****** Parameter sets: full grid, or Latin hypercube with --lhs (each range cut in <sets> strata, each stratum used once) *******************/
+    vector<model_parameters> sets;
+    if (lhs_sets > 0) {
+        mt19937 rng(seed);
+        uniform_real_distribution<float> uniform(0, 1);
+        sets.resize(lhs_sets);
+        for (size_t f = 0; f < ranges.size(); f++) {
+            vector<int> strata(lhs_sets);
+            for (int i = 0; i < lhs_sets; i++) strata[i] = i;
+            shuffle(strata.begin(), strata.end(), rng);
+            for (int i = 0; i < lhs_sets; i++) {
+                sets[i].*model_parameters::fields()[f].second = ranges[f].from + (strata[i] + uniform(rng)) / lhs_sets * (ranges[f].to - ranges[f].from);
+            }
+        }
+    } else {
+        sets.push_back(model_parameters());
+        for (size_t f = 0; f < ranges.size(); f++) {
+            vector<model_parameters> grid;
+            for (const model_parameters& set : sets) {
+                for (int i = 0; i < ranges[f].count; i++) {
+                    model_parameters point = set;
+                    point.*model_parameters::fields()[f].second = ranges[f].count == 1 ? ranges[f].from
+                        : ranges[f].from + i * (ranges[f].to - ranges[f].from) / (ranges[f].count - 1);
+                    grid.push_back(point);
+                }
+            }
+            sets = move(grid);
+        }
+    }
+    // Sets the models cannot run with are reported and left out
+    vector<int> valid;
+    for (size_t i = 0; i < sets.size(); i++) {
+        try {
+            sets[i].check();
+            valid.push_back(i);
+        } catch (const exception& e) {
+            cout << "set " << i << " skipped: " << e.what() << endl;
+        }
+    }
+
+    /****** Inputs are parsed once, every model reads the same records *******************/
+    shared_ptr<const binary_input_file> pumps_input, supply_input;
+    try {
+        pumps_input = load_input(args[1]);
+        supply_input = load_input(args[2]);
+    } catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    /************** One run per parameter set and replication, each with its own seed and logger data ************************/
+    size_t runs = valid.size() * replications;
+    vector<sweep_result> results(runs);
+    atomic<size_t> next_run(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next_run++) < runs) {
+            const model_parameters& parameters = sets[valid[i / replications]];
+            unsigned int run_seed = seed + i % replications;
+            if (continuous) {
+                results[i] = run_set<ContinuousReservoir, ContinuousWaterSupplyPump, ContinuousCityPump>(pumps_input, supply_input, run_seed, blockage_probability, parameters, until, true);
+            } else {
+                results[i] = run_set<Reservoir, WaterSupplyPump, CityPump>(pumps_input, supply_input, run_seed, blockage_probability, parameters, until, false);
+            }
+        }
+    };
+    vector<thread> pool;
+    for (unsigned int t = 0; t < min((size_t) threads, runs); t++) pool.emplace_back(worker);
+    for (thread& t : pool) t.join();
+
+    /************** One line per parameter set and replication ************************/
+    ofstream out_results(output);
+    if (!out_results) {
+        cout << "Cannot write " << output << endl;
+        return 1;
+    }
+    out_results << "set";
+    for (const auto& field : model_parameters::fields()) out_results << "," << field.first;
+    out_results << ",seed,reservoir_min_level,reservoir_max_level,reservoir_mean_level,supply_volume,city_volume,wait_minutes,blockage_minutes" << endl;
+    for (size_t i = 0; i < runs; i++) {
+        const model_parameters& parameters = sets[valid[i / replications]];
+        const sweep_result& res = results[i];
+        out_results << valid[i / replications];
+        for (const auto& field : model_parameters::fields()) out_results << "," << parameters.*field.second;
+        out_results << "," << seed + i % replications << "," << res.min_level << "," << res.max_level << "," << res.mean_level << ","
+                    << res.supply_volume << "," << res.city_volume << "," << res.wait_minutes << "," << res.blockage_minutes << endl;
+    }
+    cout << valid.size() << " parameter sets x " << replications << " replications on " << pool.size() << " threads, results in " << output << endl;
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+ * Cadmium implementation of CD++ coupled models from City Water Supply
+ *
+ * Generates the TOP model of a water network with any number of reservoirs
+ * and pumps from a network description. Every reservoir gets the same two
+ * coupled models as the hand-wired model of city_supply.hpp: a pump station
+ * (its city pumps and the reservoir) and a water supply (its supply pumps).
+ *
+ * Description file, one entry per line, '#' starts a comment:
+ *   input     <id> <file>                   input reader of start commands
+ *   reservoir <id> <station id> <city pumps input id> <supply id> <supply pumps input id>
+ *   supply    <id> <reservoir id>           water supply pump filling the reservoir
+ *   pump      <id> <reservoir id>           city pump draining the reservoir
+**/
+
+#ifndef _NETWORK_HPP__
+#define _NETWORK_HPP__
+
+//Coupled model headers (shared port definitions and input reader)
+#include "city_supply.hpp"
+
+//C++ headers
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+using namespace cadmium::basic_models::pdevs;
+
+struct network_description {
+    struct input {
+        string id;
+        string file;
+        shared_ptr<const binary_input_file> loaded; // Input already in memory (restored from a checkpoint), read instead of the file
+    };
+    struct reservoir {
+        string id;
+        string station;
+        string pumps_input;
+        string supply;
+        string supply_input;
+    };
+    struct pump {
+        string id;
+        string reservoir;
+        size_t number = 0; // 1-based position in the full description, 0 for its position in this one
+    };
+    vector<input>     inputs;
+    vector<reservoir> reservoirs;
+    vector<pump>      supply_pumps;
+    vector<pump>      city_pumps;
+};
+
+/****** Reads a network description file, throws with the line number on errors *******************/
+inline network_description read_network(const string& path) {
+    ifstream file(path);
+    if (!file) throw runtime_error("Cannot open network description " + path);
+    network_description network;
+    map<string, string> kinds; // Model id -> entry kind, to check references
+    auto check_reference = [&](const string& error, const string& id, const string& kind) {
+        auto it = kinds.find(id);
+        if (it == kinds.end()) throw runtime_error(error + "unknown " + kind + " " + id);
+        if (it->second != kind) throw runtime_error(error + "unknown " + kind + " " + id + " (declared as " + it->second + ")");
+    };
+    string line;
+    for (int number = 1; getline(file, line); number++) {
+        line = line.substr(0, line.find('#'));
+        istringstream iss(line);
+        string kind;
+        if (!(iss >> kind)) continue;
+        string error = path + ":" + to_string(number) + ": ";
+        vector<string> fields;
+        for (string field; iss >> field;) fields.push_back(field);
+        if (kind == "input" && fields.size() == 2) {
+            network.inputs.push_back({fields[0], fields[1], nullptr});
+        } else if (kind == "reservoir" && fields.size() == 5) {
+            network.reservoirs.push_back({fields[0], fields[1], fields[2], fields[3], fields[4]});
+            for (int i : {2, 4}) check_reference(error, fields[i], "input");
+        } else if ((kind == "supply" || kind == "pump") && fields.size() == 2) {
+            check_reference(error, fields[1], "reservoir");
+            (kind == "supply" ? network.supply_pumps : network.city_pumps).push_back({fields[0], fields[1], 0});
+        } else {
+            throw runtime_error(error + "cannot parse '" + line + "'");
+        }
+        if (!kinds.emplace(fields[0], kind).second) throw runtime_error(error + "duplicated id " + fields[0]);
+    }
+    return network;
+}
+
+/****** Synthetic network: reservoirs with the same number of supply and city pumps, sharing two inputs *******************/
+inline network_description make_network(int reservoirs, int pumps_per_reservoir, const string& pumps_input, const string& supply_input) {
+    network_description network;
+    network.inputs.push_back({"supply_input_reader", supply_input, nullptr});
+    network.inputs.push_back({"pumps_input_reader", pumps_input, nullptr});
+    for (int r = 1; r <= reservoirs; r++) {
+        string id = "reservoir" + to_string(r);
+        network.reservoirs.push_back({id, "PumpStation" + to_string(r), "pumps_input_reader", "WaterSupply" + to_string(r), "supply_input_reader"});
+        for (int p = 1; p <= pumps_per_reservoir; p++) {
+            int n = (r - 1) * pumps_per_reservoir + p;
+            network.supply_pumps.push_back({"supply" + to_string(n), id, 0});
+            network.city_pumps.push_back({"pump" + to_string(n), id, 0});
+        }
+    }
+    return network;
+}
+
+/****** Builds the TOP model, supply pump n (1-based, in description order, or its number) gets supply_pump_seed(seed, n), flat with <flat> *******************/
+template<typename TIME, template<typename> class RESERVOIR = Reservoir, template<typename> class SUPPLY_PUMP = WaterSupplyPump, template<typename> class CITY_PUMP = CityPump,
+         bool CHECKPOINT = false>
+shared_ptr<dynamic::modeling::coupled<TIME>> make_network_model(const network_description& network, unsigned int seed = 1,
+                                                                double blockage_probability = 0.1, TIME unblock_time = TIME("00:30:00:000"),
+                                                                const model_parameters& parameters = model_parameters(), bool flat = false) {
+    map<string, vector<shared_ptr<dynamic::modeling::model>>> supply_pumps, city_pumps;
+    for (size_t n = 0; n < network.supply_pumps.size(); n++) {
+        const network_description::pump& p = network.supply_pumps[n];
+        unsigned int pump_seed = supply_pump_seed(seed, p.number ? p.number : n + 1);
+        double probability = blockage_probability;
+        TIME unblock = unblock_time;
+        supply_pumps[p.reservoir].push_back(dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, SUPPLY_PUMP)), TIME, unsigned int, double, TIME, const model_parameters&>(
+            p.id, move(pump_seed), move(probability), move(unblock), parameters));
+    }
+    for (const network_description::pump& p : network.city_pumps) {
+        city_pumps[p.reservoir].push_back(dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, CITY_PUMP)), TIME, const model_parameters&>(p.id, parameters));
+    }
+
+    vector<model_node<TIME>> submodels_TOP;
+    vector<coupling> couplings;
+    for (const network_description::reservoir& r : network.reservoirs) {
+        const vector<shared_ptr<dynamic::modeling::model>>& supplies = supply_pumps[r.id];
+        const vector<shared_ptr<dynamic::modeling::model>>& pumps = city_pumps[r.id];
+
+        /*******Water Supply COUPLED MODEL********/
+        if (!supplies.empty()) {
+            submodels_TOP.emplace_back(r.supply, dynamic::modeling::Ports{typeid(start_supply_pumps),typeid(supply_level)}, dynamic::modeling::Ports{typeid(flow_in)},
+                                       vector<model_node<TIME>>(supplies.begin(), supplies.end()));
+        }
+        for (const shared_ptr<dynamic::modeling::model>& supply : supplies) {
+            couplings.push_back(make_coupling<iestream_input_defs<int>::out, start_supply_pumps, WaterSupplyPump_defs::start>(r.supply_input, supply->get_id()));
+            couplings.push_back(make_coupling<Reservoir_defs::level, level, supply_level, WaterSupplyPump_defs::level>(r.id, supply->get_id()));
+            couplings.push_back(make_coupling<WaterSupplyPump_defs::flow, flow_in, supply_flow_in, Reservoir_defs::flow_in>(supply->get_id(), r.id));
+        }
+
+        /*******Pump Station COUPLED MODEL********/
+        vector<model_node<TIME>> submodels_PumpStation(pumps.begin(), pumps.end());
+        submodels_PumpStation.emplace_back(dynamic::translate::make_dynamic_atomic_model<PROFILED(CHECKPOINTED_IF(CHECKPOINT, RESERVOIR)), TIME, const model_parameters&>(r.id, parameters));
+        submodels_TOP.emplace_back(r.station, dynamic::modeling::Ports{typeid(start_city_pumps),typeid(supply_flow_in)}, dynamic::modeling::Ports{typeid(level)},
+                                   move(submodels_PumpStation));
+        for (const shared_ptr<dynamic::modeling::model>& pump : pumps) {
+            couplings.push_back(make_coupling<iestream_input_defs<int>::out, start_city_pumps, CityPump_defs::start>(r.pumps_input, pump->get_id()));
+            couplings.push_back(make_coupling<CityPump_defs::flow, Reservoir_defs::flow_out>(pump->get_id(), r.id));
+            couplings.push_back(make_coupling<Reservoir_defs::level, CityPump_defs::level>(r.id, pump->get_id()));
+        }
+        couplings.push_back(make_coupling<Reservoir_defs::level, level, level>(r.id, ""));
+    }
+
+    /****** Input Readers atomic model instantiation *******************/
+    for (const network_description::input& input : network.inputs) {
+        const char * file = input.file.c_str();
+        submodels_TOP.emplace_back(input.loaded ? make_input_reader<TIME, CHECKPOINT>(input.id, input.loaded) : make_input_reader<TIME, CHECKPOINT>(input.id, file));
+    }
+
+    /*******TOP COUPLED MODEL********/
+    model_node<TIME> TOP("TOP", {}, {typeid(level)}, move(submodels_TOP));
+    return build_model(TOP, couplings, flat);
+}
+#endif // _NETWORK_HPP__
@@ -0,0 +1,127 @@
+/**
+ * Parallel simulation of a water network split by pump station
+ *
+ * partition_network() cuts a network description in partitions of whole
+ * stations (a reservoir with its supply and city pumps), keeping the
+ * description order and balancing the number of models. run_partitions()
+ * builds one TOP model per partition and runs them concurrently, each with
+ * its own runner and run_statistics data, merged at the end.
+ *
+ * This is conservative parallel DEVS in its simplest form: the stations
+ * only exchange messages with their own pumps, and the input readers have no
+ * input ports, so every partition gets its own copy of the readers it uses.
+ * No message crosses partitions, the lookahead between them is unbounded
+ * and the partitions run to the end without waiting for each other. The
+ * supply pumps keep the number they have in the full description, so each
+ * one draws the same random blockages as in the sequential run and the
+ * merged statistics are those of the sequential run.
+**/
+
+#ifndef _NETWORK_PARTITIONS_HPP__
+#define _NETWORK_PARTITIONS_HPP__
+
+//Cadmium Simulator headers
+#include <cadmium/modeling/dynamic_model.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+
+//Coupled model and logger headers
+#include "network.hpp"
+#include "../loggers/run_statistics.hpp"
+
+//C++ headers
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+/****** Splits the network in at most <partitions> descriptions of consecutive stations with about the same number of models *******************/
+inline vector<network_description> partition_network(const network_description& network, unsigned int partitions) {
+    map<string, vector<network_description::pump>> supply_pumps, city_pumps;
+    for (size_t n = 0; n < network.supply_pumps.size(); n++) {
+        network_description::pump p = network.supply_pumps[n];
+        p.number = p.number ? p.number : n + 1;
+        supply_pumps[p.reservoir].push_back(p);
+    }
+    for (const network_description::pump& p : network.city_pumps) city_pumps[p.reservoir].push_back(p);
+
+    size_t total = 0;
+    for (const network_description::reservoir& r : network.reservoirs) total += 1 + supply_pumps[r.id].size() + city_pumps[r.id].size();
+    partitions = max(1u, min(partitions, (unsigned int) network.reservoirs.size()));
+
+    vector<network_description> parts(1);
+    size_t models = 0;
+    for (size_t i = 0; i < network.reservoirs.size(); i++) {
+        const network_description::reservoir& r = network.reservoirs[i];
+        // A new partition starts once the current one has its share, leaving at least one station for each of the next ones
+        size_t left = network.reservoirs.size() - i;
+        if (!parts.back().reservoirs.empty() && parts.size() < partitions
+            && (models >= parts.size() * total / partitions || left <= partitions - parts.size())) {
+            parts.emplace_back();
+        }
+        network_description& part = parts.back();
+        part.reservoirs.push_back(r);
+        part.supply_pumps.insert(part.supply_pumps.end(), supply_pumps[r.id].begin(), supply_pumps[r.id].end());
+        part.city_pumps.insert(part.city_pumps.end(), city_pumps[r.id].begin(), city_pumps[r.id].end());
+        models += 1 + supply_pumps[r.id].size() + city_pumps[r.id].size();
+    }
+
+    // Each partition keeps the input readers of its stations, in the order of the full description
+    for (network_description& part : parts) {
+        set<string> used;
+        for (const network_description::reservoir& r : part.reservoirs) {
+            used.insert(r.pumps_input);
+            used.insert(r.supply_input);
+        }
+        for (const network_description::input& input : network.inputs) {
+            if (used.count(input.id)) part.inputs.push_back(input);
+        }
+    }
+    return parts;
+}
+
+/****** Runs every partition until <until> on up to <threads> threads and returns the merged statistics *******************/
+template<typename TIME, template<typename> class RESERVOIR = Reservoir, template<typename> class SUPPLY_PUMP = WaterSupplyPump, template<typename> class CITY_PUMP = CityPump>
+typename run_statistics<TIME>::data_type run_partitions(const vector<network_description>& partitions, unsigned int threads, const TIME& until, bool flow_rates,
+                                                        unsigned int seed = 1, double blockage_probability = 0.1, TIME unblock_time = TIME("00:30:00:000"),
+                                                        const model_parameters& parameters = model_parameters(), bool flat = false) {
+    // Models are built first, so a bad input file is reported from the calling thread
+    vector<shared_ptr<dynamic::modeling::coupled<TIME>>> tops;
+    for (const network_description& part : partitions) {
+        tops.push_back(make_network_model<TIME, RESERVOIR, SUPPLY_PUMP, CITY_PUMP>(part, seed, blockage_probability, unblock_time, parameters, flat));
+    }
+
+    vector<typename run_statistics<TIME>::data_type> results(tops.size());
+    vector<exception_ptr> errors(tops.size());
+    atomic<size_t> next_partition(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next_partition++) < tops.size()) {
+            try {
+                run_statistics<TIME>::reset(flow_rates);
+                dynamic::engine::runner<TIME, run_statistics<TIME>> r(tops[i], {0});
+                r.run_until(until);
+                run_statistics<TIME>::finish(until);
+                results[i] = move(run_statistics<TIME>::data);
+            } catch (...) {
+                errors[i] = current_exception();
+            }
+        }
+    };
+    vector<thread> pool;
+    for (unsigned int t = 0; t < min((size_t) max(1u, threads), tops.size()); t++) pool.emplace_back(worker);
+    for (thread& t : pool) t.join();
+    for (const exception_ptr& error : errors) {
+        if (error) rethrow_exception(error);
+    }
+
+    typename run_statistics<TIME>::data_type merged = results[0];
+    for (size_t i = 1; i < results.size(); i++) run_statistics<TIME>::merge(merged, results[i]);
+    return merged;
+}
+#endif // _NETWORK_PARTITIONS_HPP__
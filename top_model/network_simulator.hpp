@@ -0,0 +1,397 @@
+/**
+ * Event-queue simulator of the water network models
+ *
+ * Runs the atomic models of a network description like the dynamic runner
+ * runs the TOP model of make_network_model(), without the coupled models:
+ * where each output goes is resolved once, when the simulator is built, and
+ * the next event of every model is kept in an indexed binary heap. A step
+ * reads the imminent models from the top of the heap and only re-keys the
+ * models that transitioned (the imminent ones and the ones that got
+ * messages), so finding the next event costs O(log n) per transition instead
+ * of a pass over every model per step. scheduler::linear keeps the pass over
+ * every model, like the runner, to compare the two.
+ *
+ * Routing is sparse: an output is only routed when its bag has messages,
+ * only the models that got messages make an external transition, and a
+ * model whose next event did not move (a passive pump reading the level
+ * broadcast by its reservoir) keeps its place in the heap. Idle ports and
+ * models cost nothing in a step, the cost of a step is that of its messages.
+ *
+ * Once no pump or reservoir has an event scheduled (the pumps were stopped
+ * and the reservoir has read its last level), the network is quiescent until
+ * the next command of an input reader that gets a pump going again, and the
+ * simulator goes straight to the next command; while quiescent only the
+ * readers are looked at, also with scheduler::linear. A run with sparse
+ * commands costs its events, not its length. When the quiescence ends (or
+ * the run does) the simulator logs one info line "Quiescent from <time>
+ * until <time>", commands that left every pump stopped do not end it.
+ *
+ * Same models in the same order as make_network_model(), with the supply
+ * pumps seeded the same way. The inputs are read by BinaryInputReader (text
+ * files are parsed with load_input()), so the runs match the runner on a
+ * description of compiled (.bin) inputs. The loggers get the same calls as
+ * from the runner, except that a step only logs the state of the models that
+ * transitioned: the delta state log, the statistics and the live metrics are
+ * the same, the full state log would only be shorter.
+**/
+
+#ifndef _NETWORK_SIMULATOR_HPP__
+#define _NETWORK_SIMULATOR_HPP__
+
+//Cadmium Simulator headers
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+//Coupled model headers (network description, models and input reader)
+#include "network.hpp"
+
+//C++ headers
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace cadmium;
+
+enum class scheduler { linear, heap };
+
+template<typename TIME, typename LOGGER, template<typename> class RESERVOIR = Reservoir, template<typename> class SUPPLY_PUMP = WaterSupplyPump, template<typename> class CITY_PUMP = CityPump>
+class network_simulator {
+    using reservoir_model = RESERVOIR<TIME>;
+    using supply_model    = SUPPLY_PUMP<TIME>;
+    using city_model      = CITY_PUMP<TIME>;
+    using reader_model    = BinaryInputReader<TIME>;
+    // Ports, by position in the port tuples of the models
+    using reservoir_flow_in  = typename tuple_element<0, typename reservoir_model::input_ports>::type;
+    using reservoir_flow_out = typename tuple_element<1, typename reservoir_model::input_ports>::type;
+    using reservoir_level    = typename tuple_element<0, typename reservoir_model::output_ports>::type;
+    using supply_start       = typename tuple_element<0, typename supply_model::input_ports>::type;
+    using supply_level       = typename tuple_element<1, typename supply_model::input_ports>::type;
+    using supply_flow        = typename tuple_element<0, typename supply_model::output_ports>::type;
+    using city_start         = typename tuple_element<0, typename city_model::input_ports>::type;
+    using city_level         = typename tuple_element<1, typename city_model::input_ports>::type;
+    using city_flow          = typename tuple_element<0, typename city_model::output_ports>::type;
+    using reader_out         = typename tuple_element<0, typename reader_model::output_ports>::type;
+
+    enum kind : uint8_t { supply_pump, city_pump, reservoir, input_reader };
+    // A model in the order of make_network_model(): per reservoir its supply pumps, city pumps and the reservoir, then the input readers
+    struct node {
+        kind     type;
+        uint32_t index;     // Position in the models of its kind
+        string   id;
+        TIME     last;
+        TIME     next;
+        bool     receiving; // Got messages in this step
+    };
+
+    scheduler mode;
+    vector<node> nodes;
+    vector<reservoir_model> reservoirs;
+    vector<supply_model>    supplies;
+    vector<city_model>      pumps;
+    vector<reader_model>    readers;
+    vector<typename make_message_bags<typename reservoir_model::input_ports>::type> reservoir_inputs;
+    vector<typename make_message_bags<typename supply_model::input_ports>::type>    supply_inputs;
+    vector<typename make_message_bags<typename city_model::input_ports>::type>      pump_inputs;
+    vector<uint32_t> reservoir_node, supply_node, pump_node, reader_node;
+
+    // Where the outputs go, by model index of each kind
+    vector<uint32_t> supply_reservoir, pump_reservoir;
+    vector<vector<uint32_t>> reservoir_supplies, reservoir_pumps, reader_supplies, reader_pumps;
+
+    // Nodes as a min-heap on (next, node), every node stays in it, the passive ones at infinity
+    vector<uint32_t> heap;
+    vector<uint32_t> heap_position;
+    // Pumps and reservoirs with an event scheduled, none while the network is quiescent
+    size_t scheduled = 0;
+    TIME   quiescent_since;
+    // Step buffers, kept to not allocate at every step
+    vector<uint32_t> imminent, receivers, transitions;
+
+public:
+    network_simulator(const network_description& network, unsigned int seed = 1, double blockage_probability = 0.1,
+                      TIME unblock_time = TIME("00:30:00:000"), const model_parameters& parameters = model_parameters(),
+                      scheduler mode = scheduler::heap, const TIME& start = TIME()) : mode(mode) {
+        map<string, uint32_t> reservoir_index, reader_index;
+        for (const network_description::reservoir& r : network.reservoirs) {
+            reservoir_index.emplace(r.id, reservoirs.size());
+            reservoirs.emplace_back(parameters);
+        }
+        for (const network_description::input& input : network.inputs) {
+            reader_index.emplace(input.id, readers.size());
+            readers.emplace_back(load_input(input.file));
+        }
+        auto find = [](const map<string, uint32_t>& index, const string& id) {
+            auto it = index.find(id);
+            if (it == index.end()) throw runtime_error("Unknown model " + id + " in the network description");
+            return it->second;
+        };
+        reservoir_inputs.resize(reservoirs.size());
+        reservoir_supplies.resize(reservoirs.size());
+        reservoir_pumps.resize(reservoirs.size());
+        reader_supplies.resize(readers.size());
+        reader_pumps.resize(readers.size());
+        for (size_t n = 0; n < network.supply_pumps.size(); n++) {
+            const network_description::pump& p = network.supply_pumps[n];
+            supplies.emplace_back(supply_pump_seed(seed, p.number ? p.number : n + 1), blockage_probability, unblock_time, parameters);
+            supply_reservoir.push_back(find(reservoir_index, p.reservoir));
+            reservoir_supplies[supply_reservoir.back()].push_back(n);
+        }
+        for (size_t n = 0; n < network.city_pumps.size(); n++) {
+            pumps.emplace_back(parameters);
+            pump_reservoir.push_back(find(reservoir_index, network.city_pumps[n].reservoir));
+            reservoir_pumps[pump_reservoir.back()].push_back(n);
+        }
+        supply_inputs.resize(supplies.size());
+        pump_inputs.resize(pumps.size());
+
+        /****** Nodes in the order of the TOP model, readers routed to the pumps of the reservoirs using them *******************/
+        reservoir_node.resize(reservoirs.size());
+        supply_node.resize(supplies.size());
+        pump_node.resize(pumps.size());
+        reader_node.resize(readers.size());
+        auto add_node = [&](kind type, uint32_t index, const string& id) {
+            nodes.push_back({type, index, id, start, start, false});
+            return (uint32_t) (nodes.size() - 1);
+        };
+        for (const network_description::reservoir& r : network.reservoirs) {
+            uint32_t i = reservoir_index[r.id];
+            for (uint32_t s : reservoir_supplies[i]) supply_node[s] = add_node(supply_pump, s, network.supply_pumps[s].id);
+            for (uint32_t p : reservoir_pumps[i]) pump_node[p] = add_node(city_pump, p, network.city_pumps[p].id);
+            reservoir_node[i] = add_node(reservoir, i, r.id);
+            uint32_t supply_reader = find(reader_index, r.supply_input), pumps_reader = find(reader_index, r.pumps_input);
+            reader_supplies[supply_reader].insert(reader_supplies[supply_reader].end(), reservoir_supplies[i].begin(), reservoir_supplies[i].end());
+            reader_pumps[pumps_reader].insert(reader_pumps[pumps_reader].end(), reservoir_pumps[i].begin(), reservoir_pumps[i].end());
+        }
+        for (const network_description::input& input : network.inputs) reader_node[reader_index[input.id]] = add_node(input_reader, reader_index[input.id], input.id);
+
+        /****** Initial states and first events *******************/
+        LOGGER::template log<logger::logger_global_time, logger::run_global_time>(start);
+        for (uint32_t n = 0; n < nodes.size(); n++) {
+            nodes[n].next = start + time_advance(nodes[n]);
+            if (nodes[n].type != input_reader && nodes[n].next != numeric_limits<TIME>::infinity()) scheduled++;
+            log_state(start, n);
+            heap.push_back(n);
+            heap_position.push_back(n);
+        }
+        for (size_t i = heap.size() / 2; i-- > 0;) sift_down(i);
+        quiescent_since = start;
+    }
+
+    // Time of the next event, infinity once every model is passive
+    TIME next() const {
+        if (mode == scheduler::heap) return nodes[heap[0]].next;
+        TIME t = numeric_limits<TIME>::infinity();
+        if (!scheduled) {
+            for (uint32_t n : reader_node) t = min(t, nodes[n].next);
+        } else {
+            for (const node& m : nodes) t = min(t, m.next);
+        }
+        return t;
+    }
+
+    size_t models() const { return nodes.size(); }
+
+    void run_until(const TIME& until) {
+        if (nodes.empty()) return;
+        for (TIME t = next(); t < until; t = next()) step(t);
+        if (!scheduled) {
+            log_quiescence(until);
+            quiescent_since = until;
+        }
+    }
+
+private:
+    /****** One step: outputs of the imminent models, then the transitions of the imminent models and of the receivers, in node order *******************/
+    void step(const TIME& now) {
+        LOGGER::template log<logger::logger_global_time, logger::run_global_time>(now);
+        imminent.clear();
+        if (mode == scheduler::heap) {
+            collect_imminent(0, now);
+            sort(imminent.begin(), imminent.end());
+        } else if (!scheduled) {
+            for (uint32_t n : reader_node) {
+                if (nodes[n].next == now) imminent.push_back(n);
+            }
+        } else {
+            for (uint32_t n = 0; n < nodes.size(); n++) {
+                if (nodes[n].next == now) imminent.push_back(n);
+            }
+        }
+        for (uint32_t n : imminent) output(now, n);
+
+        sort(receivers.begin(), receivers.end());
+        transitions.clear();
+        set_union(imminent.begin(), imminent.end(), receivers.begin(), receivers.end(), back_inserter(transitions));
+        receivers.clear();
+        size_t scheduled_before = scheduled;
+        for (uint32_t n : transitions) {
+            TIME previous = nodes[n].next;
+            transition(now, n);
+            if (nodes[n].type != input_reader) {
+                scheduled += (nodes[n].next != numeric_limits<TIME>::infinity()) - (previous != numeric_limits<TIME>::infinity());
+            }
+            // A model whose next event did not move, like a passive pump reading a level, keeps its place in the heap
+            if (mode == scheduler::heap && nodes[n].next != previous) {
+                sift_up(heap_position[n]);
+                sift_down(heap_position[n]);
+            }
+        }
+        if (scheduled_before && !scheduled) quiescent_since = now;
+        if (!scheduled_before && scheduled) log_quiescence(now);
+    }
+
+    // Only the input readers had events from quiescent_since to <now>
+    void log_quiescence(const TIME& now) {
+        ostringstream& oss = line();
+        oss << "Quiescent from " << quiescent_since << " until " << now;
+        LOGGER::template log<logger::logger_info, logger::run_info>(oss.str());
+    }
+
+    // The imminent nodes are the top of the heap and its descendants with the same time
+    void collect_imminent(size_t i, const TIME& now) {
+        if (i >= heap.size() || nodes[heap[i]].next != now) return;
+        imminent.push_back(heap[i]);
+        collect_imminent(2 * i + 1, now);
+        collect_imminent(2 * i + 2, now);
+    }
+
+    void output(const TIME& now, uint32_t n) {
+        const node& m = nodes[n];
+        switch (m.type) {
+        case supply_pump: {
+            auto out = supplies[m.index].output();
+            log_messages(now, m.id, out);
+            uint32_t r = supply_reservoir[m.index];
+            append<reservoir_flow_in>(reservoir_inputs[r], get_messages<supply_flow>(out), reservoir_node[r]);
+            break;
+        }
+        case city_pump: {
+            auto out = pumps[m.index].output();
+            log_messages(now, m.id, out);
+            uint32_t r = pump_reservoir[m.index];
+            append<reservoir_flow_out>(reservoir_inputs[r], get_messages<city_flow>(out), reservoir_node[r]);
+            break;
+        }
+        case reservoir: {
+            auto out = reservoirs[m.index].output();
+            log_messages(now, m.id, out);
+            const auto& level = get_messages<reservoir_level>(out);
+            for (uint32_t s : reservoir_supplies[m.index]) append<supply_level>(supply_inputs[s], level, supply_node[s]);
+            for (uint32_t p : reservoir_pumps[m.index]) append<city_level>(pump_inputs[p], level, pump_node[p]);
+            break;
+        }
+        case input_reader: {
+            auto out = readers[m.index].output();
+            log_messages(now, m.id, out);
+            const auto& commands = get_messages<reader_out>(out);
+            for (uint32_t s : reader_supplies[m.index]) append<supply_start>(supply_inputs[s], commands, supply_node[s]);
+            for (uint32_t p : reader_pumps[m.index]) append<city_start>(pump_inputs[p], commands, pump_node[p]);
+            break;
+        }
+        }
+    }
+
+    template<typename PORT, typename BAGS, typename VALUES>
+    void append(BAGS& bags, const VALUES& values, uint32_t receiver) {
+        if (values.empty()) return;
+        auto& bag = get_messages<PORT>(bags);
+        bag.insert(bag.end(), values.begin(), values.end());
+        if (!nodes[receiver].receiving) {
+            nodes[receiver].receiving = true;
+            receivers.push_back(receiver);
+        }
+    }
+
+    void transition(const TIME& now, uint32_t n) {
+        node& m = nodes[n];
+        switch (m.type) {
+        case supply_pump:  transition(now, m, supplies[m.index], supply_inputs[m.index]); break;
+        case city_pump:    transition(now, m, pumps[m.index], pump_inputs[m.index]); break;
+        case reservoir:    transition(now, m, reservoirs[m.index], reservoir_inputs[m.index]); break;
+        case input_reader: readers[m.index].internal_transition(); break;
+        }
+        m.last = now;
+        m.next = now + time_advance(m);
+        m.receiving = false;
+        log_state(now, n);
+    }
+
+    template<typename MODEL, typename BAGS>
+    void transition(const TIME& now, const node& m, MODEL& model, BAGS& inputs) {
+        if (!m.receiving) {
+            model.internal_transition();
+            return;
+        }
+        if (m.next == now) model.confluence_transition(now - m.last, move(inputs));
+        else model.external_transition(now - m.last, move(inputs));
+        inputs = BAGS();
+    }
+
+    TIME time_advance(const node& m) const {
+        switch (m.type) {
+        case supply_pump: return supplies[m.index].time_advance();
+        case city_pump:   return pumps[m.index].time_advance();
+        case reservoir:   return reservoirs[m.index].time_advance();
+        default:          return readers[m.index].time_advance();
+        }
+    }
+
+    /****** Log lines of the runner: "[<port>: {<values>}]" generated by the model, its state as its operator<< writes it *******************/
+    template<typename BAGS>
+    static void log_messages(const TIME& now, const string& id, const BAGS& out) {
+        // Every model has one output port, formatted by its bag's operator<< in the stream of the thread
+        ostringstream& oss = line();
+        oss << get<0>(out);
+        LOGGER::template log<logger::logger_messages, logger::sim_messages_collect>(now, id, oss.str());
+    }
+
+    // Stream the log lines are formatted in, built once per thread
+    static ostringstream& line() {
+        static thread_local ostringstream oss;
+        oss.str(string());
+        return oss;
+    }
+
+    void log_state(const TIME& now, uint32_t n) const {
+        const node& m = nodes[n];
+        ostringstream& oss = line();
+        switch (m.type) {
+        case supply_pump:  oss << supplies[m.index].state; break;
+        case city_pump:    oss << pumps[m.index].state; break;
+        case reservoir:    oss << reservoirs[m.index].state; break;
+        case input_reader: oss << readers[m.index].state; break;
+        }
+        LOGGER::template log<logger::logger_state, logger::sim_state>(now, m.id, oss.str());
+    }
+
+    /****** Indexed binary heap *******************/
+    bool before(uint32_t a, uint32_t b) const {
+        return nodes[a].next < nodes[b].next || (nodes[a].next == nodes[b].next && a < b);
+    }
+    void place(size_t i, uint32_t n) {
+        heap[i] = n;
+        heap_position[n] = i;
+    }
+    void sift_up(size_t i) {
+        uint32_t n = heap[i];
+        for (; i > 0 && before(n, heap[(i - 1) / 2]); i = (i - 1) / 2) place(i, heap[(i - 1) / 2]);
+        place(i, n);
+    }
+    void sift_down(size_t i) {
+        uint32_t n = heap[i];
+        for (size_t child; (child = 2 * i + 1) < heap.size(); i = child) {
+            if (child + 1 < heap.size() && before(heap[child + 1], heap[child])) child++;
+            if (!before(heap[child], n)) break;
+            place(i, heap[child]);
+        }
+        place(i, n);
+    }
+};
+#endif // _NETWORK_SIMULATOR_HPP__